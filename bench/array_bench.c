@@ -0,0 +1,61 @@
+/*
+ * Compares checking that every element of a large array of doubles is in a
+ * range with assert_ge() and assert_le() on each element and with
+ * assert_all_in_range() using the scalar, SSE2 and AVX2 kernels, and reports
+ * the throughput of each in bytes per nanosecond (GB/s).
+ */
+#include "bench.h"
+#include "dare.h"
+
+#define ELEMENTS (8L * 1024 * 1024)
+#define ROUNDS 20
+#define RANGE_EXCEPTION 4200
+
+static double values[ELEMENTS];
+
+__attribute__((noinline))
+Exception each_in_range(double const *a, size_t n) {
+  try (
+    for (size_t i = 0; i < n; i++) {
+      assert_ge(a[i], 0.0, "Below range", RANGE_EXCEPTION)
+      assert_le(a[i], 1.0, "Above range", RANGE_EXCEPTION)
+    }
+  ) catch (
+    return EVAR;
+  )
+  return SUCCESS;
+}
+
+__attribute__((noinline))
+Exception all_in_range(double const *a, size_t n) {
+  try (
+    assert_all_in_range(a, n, 0.0, 1.0, "Out of range", RANGE_EXCEPTION)
+  ) catch (
+    return EVAR;
+  )
+  return SUCCESS;
+}
+
+static void report(char const *name, double ns) {
+  printf("%-32s %8.2f GB/s\n", name, (double) ROUNDS * sizeof values / ns);
+}
+
+static double run(Exception (*range)(double const *, size_t)) {
+  double start = bench_now();
+  for (int r = 0; r < ROUNDS; r++)
+    cancel(range(values, ELEMENTS));
+  return bench_now() - start;
+}
+
+int main() {
+  for (long i = 0; i < ELEMENTS; i++) values[i] = (double) (i % 1000) / 1000;
+
+  report("assert_ge/assert_le per element", run(each_in_range));
+  dare_array_use(DARE_ISA_SCALAR);
+  report("assert_all_in_range scalar", run(all_in_range));
+  if (dare_array_use(DARE_ISA_SSE2) == DARE_ISA_SSE2)
+    report("assert_all_in_range SSE2", run(all_in_range));
+  if (dare_array_use(DARE_ISA_AVX2) == DARE_ISA_AVX2)
+    report("assert_all_in_range AVX2", run(all_in_range));
+  return 0;
+}
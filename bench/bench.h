@@ -0,0 +1,21 @@
+#ifndef BENCH_H
+#define BENCH_H
+#include <stdio.h>
+#include <time.h>
+
+//! Read the monotonic clock in nanoseconds.
+static inline double bench_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+//! Keep the compiler from discarding a value computed by a benchmark.
+#define bench_keep(X) __asm__ volatile ("" : : "g"(X) : "memory")
+
+//! Print one result line: the name and the average cost of an iteration.
+static inline void bench_report(char const *name, double ns, long iterations) {
+  printf("%-32s %8.2f ns/op\n", name, ns / iterations);
+}
+
+#endif
@@ -0,0 +1,136 @@
+/*
+ * Compares the hot loop of a stack kernel like the one in `example/` built
+ * with the macros as they were before the failure paths were outlined
+ * (`legacy_*`) and with the current macros (`outlined_*`).
+ *
+ * `make` runs the throughput comparison and lists the size of each kernel.
+ */
+#include "bench.h"
+#include "dare.h"
+
+#define ITERATIONS 50000000L
+#define S_MAX 64
+#define STACK_EXCEPTION 3000
+
+// the macros as they used to expand, everything inlined in the caller
+#define legacy_check(EXPR) { \
+  dare_thrown = EXPR; \
+  if (dare_thrown != SUCCESS) { \
+    dare_thrown = add_line(dare_thrown, "  at " __FILE__ ":" xstr(__LINE__)); \
+    goto dare_failure; \
+  } \
+}
+#define legacy_throw(MSG, CODE) { \
+  dare_thrown = new_exception(MSG, CODE, NULL); \
+  dare_thrown = add_line(dare_thrown, "  at " __FILE__ ":" xstr(__LINE__)); \
+  goto dare_failure; \
+}
+#define legacy_assert_true(X, MSG, CODE) { if (!(X)) legacy_throw(MSG, CODE) }
+
+typedef struct {
+  long vet[S_MAX];
+  int depth;
+} Stack;
+
+__attribute__((noinline))
+Exception legacy_push(Stack *s, long e) {
+  try (
+    legacy_assert_true(s != NULL, "Null stack", STACK_EXCEPTION);
+    legacy_assert_true(s->depth < S_MAX, "The stack is too full!", STACK_EXCEPTION);
+    s->vet[s->depth++] = e;
+    return SUCCESS;
+  ) catch (
+    return EVAR;
+  )
+}
+
+__attribute__((noinline))
+Exception legacy_pop(Stack *s, long *e) {
+  try (
+    legacy_assert_true(s != NULL, "Null stack", STACK_EXCEPTION);
+    legacy_assert_true(s->depth > 0, "The stack is empty!", STACK_EXCEPTION);
+    *e = s->vet[--s->depth];
+    return SUCCESS;
+  ) catch (
+    return EVAR;
+  )
+}
+
+__attribute__((noinline))
+Exception legacy_kernel(Stack *s, long n) {
+  try (
+    long x = 0;
+    long y;
+    for (long i = 0; i < n; i++) {
+      legacy_check(legacy_push(s, i));
+      legacy_check(legacy_push(s, 1));
+      legacy_check(legacy_pop(s, &x));
+      legacy_check(legacy_pop(s, &y));
+      legacy_check(legacy_push(s, x + y));
+      legacy_check(legacy_pop(s, &x));
+    }
+    bench_keep(x);
+    return SUCCESS;
+  ) catch (
+    return EVAR;
+  )
+}
+
+__attribute__((noinline))
+Exception outlined_push(Stack *s, long e) {
+  try (
+    assert_not_null(s, "Null stack", STACK_EXCEPTION);
+    assert_lt(s->depth, S_MAX, "The stack is too full!", STACK_EXCEPTION);
+    s->vet[s->depth++] = e;
+    return SUCCESS;
+  ) catch (
+    return EVAR;
+  )
+}
+
+__attribute__((noinline))
+Exception outlined_pop(Stack *s, long *e) {
+  try (
+    assert_not_null(s, "Null stack", STACK_EXCEPTION);
+    assert_gt(s->depth, 0, "The stack is empty!", STACK_EXCEPTION);
+    *e = s->vet[--s->depth];
+    return SUCCESS;
+  ) catch (
+    return EVAR;
+  )
+}
+
+__attribute__((noinline))
+Exception outlined_kernel(Stack *s, long n) {
+  try (
+    long x = 0;
+    long y;
+    for (long i = 0; i < n; i++) {
+      check(outlined_push(s, i));
+      check(outlined_push(s, 1));
+      check(outlined_pop(s, &x));
+      check(outlined_pop(s, &y));
+      check(outlined_push(s, x + y));
+      check(outlined_pop(s, &x));
+    }
+    bench_keep(x);
+    return SUCCESS;
+  ) catch (
+    return EVAR;
+  )
+}
+
+int main() {
+  Stack s = { .depth = 0 };
+  double start;
+
+  start = bench_now();
+  cancel(legacy_kernel(&s, ITERATIONS));
+  bench_report("legacy (inline failure path)", bench_now() - start, ITERATIONS);
+
+  start = bench_now();
+  cancel(outlined_kernel(&s, ITERATIONS));
+  bench_report("outlined (cold failure path)", bench_now() - start, ITERATIONS);
+
+  return 0;
+}
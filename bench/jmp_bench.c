@@ -0,0 +1,73 @@
+/*
+ * Compares the cost of propagating an Exception through call chains of
+ * several depths by returning it, with check() in every frame, and by jumping
+ * straight to the handler with throw_jmp().
+ *
+ * The success path measures a whole descent that does not throw, the failure
+ * path one that throws at the bottom and is caught at the top.
+ */
+#include "bench.h"
+#include "dare.h"
+
+#define ITERATIONS 1000000L
+#define BOTTOM_EXCEPTION 4000
+
+__attribute__((noinline))
+Exception return_level(int depth, int fail) {
+  try (
+    if (depth == 0) {
+      if (fail) throw("Bottom reached", BOTTOM_EXCEPTION);
+      return SUCCESS;
+    }
+    check(return_level(depth - 1, fail));
+    return SUCCESS;
+  ) catch (
+    return EVAR;
+  )
+}
+
+__attribute__((noinline))
+int jmp_level(int depth, int fail) {
+  if (depth == 0) {
+    if (fail) throw_jmp("Bottom reached", BOTTOM_EXCEPTION);
+    return 0;
+  }
+  return jmp_level(depth - 1, fail) + 1;
+}
+
+static double run_return(int depth, int fail) {
+  double start = bench_now();
+  for (long i = 0; i < ITERATIONS; i++)
+    cancel(return_level(depth, fail));
+  return bench_now() - start;
+}
+
+static double run_jmp(int depth, int fail) {
+  double start = bench_now();
+  for (volatile long i = 0; i < ITERATIONS; i++) {
+    try_jmp (
+      bench_keep(jmp_level(depth, fail));
+    ) catch_jmp (
+      cancel(EVAR);
+    )
+  }
+  return bench_now() - start;
+}
+
+int main() {
+  int depths[] = { 1, 4, 16, 30 };
+  char name[64];
+
+  for (size_t i = 0; i < sizeof depths / sizeof *depths; i++) {
+    int d = depths[i];
+    snprintf(name, sizeof name, "return success depth %d", d);
+    bench_report(name, run_return(d, 0), ITERATIONS);
+    snprintf(name, sizeof name, "longjmp success depth %d", d);
+    bench_report(name, run_jmp(d, 0), ITERATIONS);
+    snprintf(name, sizeof name, "return failure depth %d", d);
+    bench_report(name, run_return(d, 1), ITERATIONS);
+    snprintf(name, sizeof name, "longjmp failure depth %d", d);
+    bench_report(name, run_jmp(d, 1), ITERATIONS);
+  }
+  return 0;
+}
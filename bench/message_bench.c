@@ -0,0 +1,62 @@
+/*
+ * Compares the cost of throwing and cancelling an Exception whose message is
+ * a literal, is formatted at once with throwf() and is captured for later
+ * formatting with throwf_lazy(), and the cost of reading the lazy message.
+ */
+#include "bench.h"
+#include "dare.h"
+
+#define ITERATIONS 1000000L
+#define LOOKUP_EXCEPTION 4100
+
+__attribute__((noinline))
+Exception literal_lookup(char const *key, long shard) {
+  try (
+    if (shard >= 0) throw("Key not found", LOOKUP_EXCEPTION);
+    bench_keep((long) key);
+  ) catch (
+    return EVAR;
+  )
+  return SUCCESS;
+}
+
+__attribute__((noinline))
+Exception eager_lookup(char const *key, long shard) {
+  try (
+    if (shard >= 0)
+      throwf(LOOKUP_EXCEPTION, "Key %s not found in shard %ld", key, shard);
+  ) catch (
+    return EVAR;
+  )
+  return SUCCESS;
+}
+
+__attribute__((noinline))
+Exception lazy_lookup(char const *key, long shard) {
+  try (
+    if (shard >= 0)
+      throwf_lazy(LOOKUP_EXCEPTION, "Key %s not found in shard %ld", key, shard);
+  ) catch (
+    return EVAR;
+  )
+  return SUCCESS;
+}
+
+static double run(Exception (*lookup)(char const *, long), int read) {
+  double start = bench_now();
+  for (long i = 0; i < ITERATIONS; i++) {
+    Exception e = lookup("user:1234", i);
+    if (read) bench_keep((long) get_msg(e));
+    cancel(e);
+  }
+  return bench_now() - start;
+}
+
+int main() {
+  bench_report("literal message", run(literal_lookup, 0), ITERATIONS);
+  bench_report("throwf unread", run(eager_lookup, 0), ITERATIONS);
+  bench_report("throwf_lazy unread", run(lazy_lookup, 0), ITERATIONS);
+  bench_report("throwf read", run(eager_lookup, 1), ITERATIONS);
+  bench_report("throwf_lazy read", run(lazy_lookup, 1), ITERATIONS);
+  return 0;
+}
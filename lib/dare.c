@@ -22,9 +22,15 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 #include "dare.h"
+#include <errno.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 struct exception_line_st {
 	char const *str;
@@ -32,19 +38,384 @@ struct exception_line_st {
 	struct exception_line_st *below;
 };
 
+// Where the message or the detail of an Exception is stored.
+enum msg_kind {
+	MSG_BORROWED, // owned by someone else, usually a string literal
+	MSG_INLINE,   // in the text buffer of the Exception
+	MSG_HEAP,     // in the heap, freed with the Exception
+	MSG_LAZY,     // not rendered yet, the string is the format of the lazy args
+	MSG_ERRNO,    // not rendered yet, msg is the expression that set errno
+};
+
+// The captured arguments of a lazily formatted message.
+struct lazy_msg {
+	union dare_value values[DARE_LAZY_ARGS];
+	unsigned char kinds[DARE_LAZY_ARGS];
+	unsigned char count;
+};
+
+// The fields of an Exception, whose keys are kept apart to be scanned quickly.
+union field_value {
+	int64_t i;
+	double d;
+	void const *p;
+	char s[DARE_FIELD_STR_SIZE];
+};
+
+struct fields_st {
+	char const *keys[DARE_FIELDS];
+	unsigned char kinds[DARE_FIELDS];
+	unsigned char count;
+	union field_value values[DARE_FIELDS];
+};
+
+// Whether an Exception belongs to a block made by compact().
+enum block_kind {
+	BLOCK_NONE,
+	BLOCK_HEAD,   // the first Exception of a block, which frees it
+	BLOCK_MEMBER, // one of its causes, freed with the head
+};
+
+// Whether an Exception can still change and whether it is ever freed.
+enum freeze_kind {
+	THAWED,
+	FROZEN,         // shared, freed with the last reference
+	FROZEN_FOREVER, // never freed
+};
+
+// The link comes first, so that queues can convert between the two.
 struct exception_st {
+	struct dare_link link;
 	char const *msg;
 	int code;
+	int error;
+	enum msg_kind msg_kind;
+	char const *detail;
+	enum msg_kind detail_kind;
+	enum block_kind block;
+	unsigned char frozen;
+	_Atomic unsigned refs;
+	int depth;
+	struct exception_st *root;
+	uint64_t fingerprint;
+	struct aggregate_st *aggregate;
+	int transient;
+	int attempts;
+	int64_t retry_after;
+	struct fields_st fields;
+	unsigned char context_count;
+	struct dare_context_entry context[DARE_CONTEXT_MAX];
 	struct exception_st *cause;
 	struct exception_line_st *top;
 	struct exception_line_st *bottom;
+	unsigned char line_count; // how many of the inline lines are taken
+	struct exception_line_st lines[DARE_INLINE_LINES];
+	union {
+		char text[DARE_INLINE_MSG]; // for either the message or the detail
+		struct lazy_msg lazy;
+	};
+};
+
+_Static_assert(sizeof(struct lazy_msg) <= DARE_INLINE_MSG,
+               "the lazy arguments must fit in the inline message buffer");
+_Static_assert(offsetof(struct exception_st, link) == 0,
+               "the link must be the first member of an Exception");
+
+/*
+ * The slot table. The generation of a slot is odd while its Exception is
+ * alive. The free slots form a stack whose head packs a tag with the index,
+ * so a slot popped and pushed back in between is not mistaken for the same
+ * head (ABA). Slots never used yet are taken from `fresh`.
+ */
+#define NO_SLOT UINT32_MAX
+#define GENERATION_MASK (UINT32_MAX >> DARE_SLOT_BITS)
+
+struct slot_st {
+	struct exception_st exception;
+	_Atomic uint32_t generation;
+	_Atomic uint32_t next;
+};
+
+_Thread_local struct dare_context dare_context = { 0 };
+
+static struct slot_st slots[DARE_SLOTS];
+static _Atomic uint64_t free_head = NO_SLOT;
+static _Atomic uint32_t fresh = 0;
+
+static struct slot_st *slot_of(Exception e) {
+	uintptr_t offset = (uintptr_t) e - (uintptr_t) slots;
+	if (offset >= sizeof slots) return NULL;
+	return (struct slot_st *) e;
+}
+
+static Exception alloc_exception(void) {
+	uint64_t head = atomic_load_explicit(&free_head, memory_order_acquire);
+	while ((uint32_t) head != NO_SLOT) {
+		uint32_t index = (uint32_t) head;
+		uint64_t next = ((head >> 32) + 1) << 32
+		              | atomic_load_explicit(&slots[index].next, memory_order_relaxed);
+		if (atomic_compare_exchange_weak_explicit(&free_head, &head, next,
+		    memory_order_acquire, memory_order_acquire)) {
+			atomic_fetch_add_explicit(&slots[index].generation, 1,
+			                          memory_order_release);
+			return &slots[index].exception;
+		}
+	}
+
+	if (atomic_load_explicit(&fresh, memory_order_relaxed) < DARE_SLOTS) {
+		uint32_t index = atomic_fetch_add_explicit(&fresh, 1, memory_order_relaxed);
+		if (index < DARE_SLOTS) {
+			atomic_store_explicit(&slots[index].generation, 1, memory_order_release);
+			return &slots[index].exception;
+		}
+	}
+
+	return malloc(sizeof (struct exception_st));
+}
+
+/*
+ * Mark a pooled Exception as dead, so its handles become stale. Return false
+ * if it was already dead, always true for those from the heap.
+ */
+static int claim_exception(Exception e) {
+	struct slot_st *slot = slot_of(e);
+	if (!slot) return 1;
+
+	uint32_t generation = atomic_load_explicit(&slot->generation,
+	                                           memory_order_acquire);
+	do {
+		if (!(generation & 1)) return 0;
+	} while (!atomic_compare_exchange_weak_explicit(&slot->generation,
+	         &generation, generation + 1, memory_order_acq_rel,
+	         memory_order_acquire));
+	return 1;
+}
+
+// Give the memory of a claimed Exception back to the table or the heap.
+static void release_exception(Exception e) {
+	struct slot_st *slot = slot_of(e);
+	if (!slot) {
+		free(e);
+		return;
+	}
+
+	uint32_t index = slot - slots;
+	uint64_t head = atomic_load_explicit(&free_head, memory_order_relaxed);
+	uint64_t next;
+	do {
+		atomic_store_explicit(&slot->next, (uint32_t) head, memory_order_relaxed);
+		next = ((head >> 32) + 1) << 32 | index;
+	} while (!atomic_compare_exchange_weak_explicit(&free_head, &head, next,
+	         memory_order_release, memory_order_relaxed));
+}
+
+// Output of the renderer, which counts what does not fit like snprintf().
+struct sink {
+	char *out;
+	size_t size;
+	size_t used;
 };
 
+static void put(struct sink *s, char const *fmt, ...) {
+	size_t room = s->used < s->size ? s->size - s->used : 0;
+	va_list ap;
+	va_start(ap, fmt);
+	int n = vsnprintf(room ? s->out + s->used : NULL, room, fmt, ap);
+	va_end(ap);
+	if (n > 0) s->used += n;
+}
+
+static long long as_int(struct lazy_msg const *l, int i) {
+	switch (l->kinds[i]) {
+	case DARE_ARG_DOUBLE: return (long long) l->values[i].d;
+	case DARE_ARG_PTR:
+	case DARE_ARG_STR: return (long long) (intptr_t) l->values[i].p;
+	default: return l->values[i].i;
+	}
+}
+
+static double as_double(struct lazy_msg const *l, int i) {
+	switch (l->kinds[i]) {
+	case DARE_ARG_INT: return l->values[i].i;
+	case DARE_ARG_UINT: return l->values[i].u;
+	case DARE_ARG_DOUBLE: return l->values[i].d;
+	default: return 0;
+	}
+}
+
+static void const *as_ptr(struct lazy_msg const *l, int i) {
+	switch (l->kinds[i]) {
+	case DARE_ARG_PTR:
+	case DARE_ARG_STR: return l->values[i].p;
+	default: return NULL;
+	}
+}
+
+// The conversion that prints an argument as the type it was captured with.
+static char as_captured(struct lazy_msg const *l, int i) {
+	switch (l->kinds[i]) {
+	case DARE_ARG_INT: return 'd';
+	case DARE_ARG_UINT: return 'u';
+	case DARE_ARG_DOUBLE: return 'g';
+	default: return 'p';
+	}
+}
+
+/*
+ * Render a lazily formatted message. Each conversion is passed to snprintf()
+ * on its own, with its length modifier replaced by one matching the type the
+ * argument was captured with, and %v replaced by the conversion for it.
+ */
+static size_t render(struct lazy_msg const *l, char const *fmt, char *out,
+                     size_t size) {
+	struct sink s = { out, size, 0 };
+	int next = 0;
+	char const *p = fmt;
+	if (size) out[0] = '\0';
+
+	while (*p) {
+		if (*p != '%') {
+			char const *end = p;
+			while (*end && *end != '%') end++;
+			put(&s, "%.*s", (int) (end - p), p);
+			p = end;
+			continue;
+		}
+		if (p[1] == '%') {
+			put(&s, "%%");
+			p += 2;
+			continue;
+		}
+
+		char spec[48] = "%";
+		size_t len = 1;
+		p++;
+		while (*p && strchr("-+ #0", *p) && len < 8) spec[len++] = *p++;
+		for (int part = 0; part < 2; part++) {
+			if (part && *p != '.') break;
+			if (part) spec[len++] = *p++;
+			if (*p == '*') {
+				p++;
+				int star = next < l->count ? (int) as_int(l, next++) : 0;
+				len += snprintf(spec + len, 12, "%d", star);
+			} else {
+				while (*p >= '0' && *p <= '9') {
+					if (len < 20) spec[len++] = *p;
+					p++;
+				}
+			}
+		}
+		while (*p && strchr("hlLjztq", *p)) p++;
+		char conv = *p;
+		if (!conv) break;
+		p++;
+
+		if (next >= l->count) {
+			put(&s, "?");
+			continue;
+		}
+		int i = next++;
+		if (conv == 'v') conv = as_captured(l, i);
+		switch (conv) {
+		case 'd': case 'i':
+			memcpy(spec + len, "ll", 2);
+			spec[len + 2] = conv;
+			put(&s, spec, as_int(l, i));
+			break;
+		case 'u': case 'o': case 'x': case 'X':
+			memcpy(spec + len, "ll", 2);
+			spec[len + 2] = conv;
+			put(&s, spec, (unsigned long long) as_int(l, i));
+			break;
+		case 'c':
+			spec[len] = conv;
+			put(&s, spec, (int) as_int(l, i));
+			break;
+		case 'e': case 'E': case 'f': case 'F':
+		case 'g': case 'G': case 'a': case 'A':
+			spec[len] = conv;
+			put(&s, spec, as_double(l, i));
+			break;
+		case 's': case 'p':
+			spec[len] = conv;
+			put(&s, spec, as_ptr(l, i));
+			break;
+		default:
+			put(&s, "?");
+			break;
+		}
+	}
+	return s.used;
+}
+
+/*
+ * Render the message or the detail of an Exception if it was formatted
+ * lazily, caching it in place of the arguments or in the heap. If the heap is
+ * exhausted it is truncated.
+ */
+static char const *render_lazy(Exception e, char const *fmt,
+                               enum msg_kind *kind) {
+	char text[DARE_INLINE_MSG];
+	size_t len = render(&e->lazy, fmt, text, sizeof text);
+	if (len >= sizeof text) {
+		char *heap = malloc(len + 1);
+		if (heap) {
+			render(&e->lazy, fmt, heap, len + 1);
+			*kind = MSG_HEAP;
+			return heap;
+		}
+	}
+	memcpy(e->text, text, sizeof text);
+	*kind = MSG_INLINE;
+	return e->text;
+}
+
+static char const *gnu_strerror(char const *text, char *buf) {
+	(void) buf;
+	return text;
+}
+
+static char const *xsi_strerror(int failed, char *buf) {
+	return failed ? "Unknown error" : buf;
+}
+
+// strerror_r() returns the text with _GNU_SOURCE, and fills the buffer without.
+#define describe_errno(ERROR, BUF) _Generic(strerror_r(ERROR, BUF, sizeof BUF), \
+	char *: gnu_strerror, default: xsi_strerror)( \
+	strerror_r(ERROR, BUF, sizeof BUF), BUF)
+
+// Render the message of an Exception thrown for errno, like format_msg().
+static void render_errno(Exception e) {
+	char buf[128];
+	char const *expr = e->msg;
+	char const *text = describe_errno(e->error, buf);
+	int len = snprintf(e->text, sizeof e->text, "%s: %s", expr, text);
+
+	e->msg = e->text;
+	e->msg_kind = MSG_INLINE;
+	if (len < 0 || (size_t) len < sizeof e->text) return;
+
+	char *heap = malloc(len + 1);
+	if (!heap) return;
+	snprintf(heap, len + 1, "%s: %s", expr, text);
+	e->msg = heap;
+	e->msg_kind = MSG_HEAP;
+}
+
 char const * get_msg(Exception e) {
 	if (!e) return NULL;
+	if (e->msg_kind == MSG_LAZY) e->msg = render_lazy(e, e->msg, &e->msg_kind);
+	if (e->msg_kind == MSG_ERRNO) render_errno(e);
 	return e->msg;
 }
 
+char const *get_detail(Exception e) {
+	if (!e) return NULL;
+	if (e->detail_kind == MSG_LAZY)
+		e->detail = render_lazy(e, e->detail, &e->detail_kind);
+	return e->detail;
+}
+
 int get_code(Exception e) {
 	if (!e) return 0;
 	return e->code;
@@ -55,50 +426,353 @@ Exception get_cause(Exception e) {
 	return e->cause;
 }
 
-void fprint_stacktrace(FILE *fp, Exception e) {
-	if (!e || !fp) return;
-	
-	fprintf(fp, "Exception: (%d) %s\n", e->code, e->msg);
+/*
+ * Fingerprints are 64 bit FNV-1a hashes, fed with the code, the fingerprint
+ * of the cause and the contents of the lines, never with addresses, so they
+ * are stable between runs.
+ */
+#define FNV_OFFSET 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+static uint64_t hash(uint64_t h, void const *data, size_t len) {
+	unsigned char const *byte = data;
+	while (len--) {
+		h ^= *byte++;
+		h *= FNV_PRIME;
+	}
+	return h;
+}
+
+uint64_t get_fingerprint(Exception e) {
+	if (!e) return 0;
+	return e->fingerprint;
+}
+
+int same_fingerprint(Exception a, Exception b) {
+	if (!a || !b) return 0;
+	return a->fingerprint == b->fingerprint;
+}
+
+int same_error(Exception a, Exception b) {
+	if (!a || !b) return 0;
+	if (a->fingerprint != b->fingerprint || a->depth != b->depth) return 0;
+
+	for (; a && b; a = a->cause, b = b->cause) {
+		if (a->code != b->code) return 0;
+		struct exception_line_st *x = a->bottom, *y = b->bottom;
+		for (; x && y; x = x->above, y = y->above)
+			if (x->str != y->str && strcmp(x->str, y->str)) return 0;
+		if (x || y) return 0;
+	}
+	return !a && !b;
+}
+
+Exception get_root_cause(Exception e) {
+	if (!e) return NULL;
+	return e->root;
+}
+
+int get_depth(Exception e) {
+	if (!e) return 0;
+	return e->depth;
+}
+
+Exception find_cause_by_code(Exception e, int code) {
+	for (; e; e = e->cause)
+		if (e->code == code) return e;
+	return NULL;
+}
+
+static int find_field(struct fields_st const *f, char const *key) {
+	int i;
+	for (i = 0; i < f->count; i++)
+		if (f->keys[i] == key) return i;
+	for (i = 0; i < f->count; i++)
+		if (!strcmp(f->keys[i], key)) return i;
+	return -1;
+}
+
+// Find the field to be set, adding it if the key is new.
+static union field_value *set_field(Exception e, char const *key,
+                                    enum dare_field_kind kind) {
+	if (!e || !key || e->frozen) return NULL;
+
+	struct fields_st *f = &e->fields;
+	int i = find_field(f, key);
+	if (i < 0) {
+		if (f->count == DARE_FIELDS) return NULL;
+		i = f->count++;
+		f->keys[i] = key;
+	}
+	f->kinds[i] = kind;
+	return &f->values[i];
+}
+
+static union field_value const *get_field(Exception e, char const *key,
+                                          enum dare_field_kind kind) {
+	if (!e || !key) return NULL;
+
+	int i = find_field(&e->fields, key);
+	if (i < 0 || e->fields.kinds[i] != kind) return NULL;
+	return &e->fields.values[i];
+}
+
+int dare_set_int(Exception e, char const *key, int64_t value) {
+	union field_value *v = set_field(e, key, DARE_FIELD_INT);
+	if (!v) return -1;
+	v->i = value;
+	return 0;
+}
+
+int dare_set_double(Exception e, char const *key, double value) {
+	union field_value *v = set_field(e, key, DARE_FIELD_DOUBLE);
+	if (!v) return -1;
+	v->d = value;
+	return 0;
+}
+
+int dare_set_str(Exception e, char const *key, char const *value) {
+	if (!value) return -1;
+	union field_value *v = set_field(e, key, DARE_FIELD_STR);
+	if (!v) return -1;
+	size_t len = strnlen(value, sizeof v->s - 1);
+	memcpy(v->s, value, len);
+	v->s[len] = '\0';
+	return 0;
+}
+
+int dare_set_ptr(Exception e, char const *key, void const *value) {
+	union field_value *v = set_field(e, key, DARE_FIELD_PTR);
+	if (!v) return -1;
+	v->p = value;
+	return 0;
+}
+
+int dare_get_int(Exception e, char const *key, int64_t *value) {
+	union field_value const *v = get_field(e, key, DARE_FIELD_INT);
+	if (!v || !value) return -1;
+	*value = v->i;
+	return 0;
+}
+
+int dare_get_double(Exception e, char const *key, double *value) {
+	union field_value const *v = get_field(e, key, DARE_FIELD_DOUBLE);
+	if (!v || !value) return -1;
+	*value = v->d;
+	return 0;
+}
+
+int dare_get_str(Exception e, char const *key, char const **value) {
+	union field_value const *v = get_field(e, key, DARE_FIELD_STR);
+	if (!v || !value) return -1;
+	*value = v->s;
+	return 0;
+}
+
+int dare_get_ptr(Exception e, char const *key, void const **value) {
+	union field_value const *v = get_field(e, key, DARE_FIELD_PTR);
+	if (!v || !value) return -1;
+	*value = v->p;
+	return 0;
+}
+
+int dare_field_count(Exception e) {
+	if (!e) return 0;
+	return e->fields.count;
+}
+
+int dare_field_at(Exception e, int index, char const **key) {
+	if (!e || index < 0 || index >= e->fields.count) return -1;
+	if (key) *key = e->fields.keys[index];
+	return e->fields.kinds[index];
+}
+
+static void fprint_fields(FILE *fp, struct fields_st const *f) {
+	if (!f->count) return;
+
+	fputs("  with", fp);
+	for (int i = 0; i < f->count; i++) {
+		union field_value const *v = &f->values[i];
+		fprintf(fp, " %s=", f->keys[i]);
+		switch (f->kinds[i]) {
+		case DARE_FIELD_INT: fprintf(fp, "%" PRId64, v->i); break;
+		case DARE_FIELD_DOUBLE: fprintf(fp, "%g", v->d); break;
+		case DARE_FIELD_STR: fprintf(fp, "\"%s\"", v->s); break;
+		case DARE_FIELD_PTR: fprintf(fp, "%p", v->p); break;
+		}
+	}
+	fputc('\n', fp);
+}
+
+int dare_context_count(Exception e) {
+	if (!e) return 0;
+	return e->context_count;
+}
+
+struct dare_context_entry const *dare_context_at(Exception e, int index) {
+	if (!e || index < 0 || index >= e->context_count) return NULL;
+	return &e->context[index];
+}
+
+static void fprint_context(FILE *fp, Exception e) {
+	if (!e->context_count) return;
+
+	fputs("  in", fp);
+	for (int i = 0; i < e->context_count; i++) {
+		struct dare_context_entry const *c = &e->context[i];
+		if (c->str)
+			fprintf(fp, " %s=%s", c->label, c->str);
+		else
+			fprintf(fp, " %s=%" PRId64, c->label, c->value);
+	}
+	fputc('\n', fp);
+}
+
+static void fprint_exception(FILE *fp, char const *label, Exception e) {
+	fprintf(fp, "%s: (%d) %s\n", label, e->code, get_msg(e));
+	if (get_detail(e)) fprintf(fp, "  %s\n", e->detail);
+	fprint_fields(fp, &e->fields);
+	fprint_context(fp, e);
 	struct exception_line_st *line = e->bottom;
 	while (line) {
-		puts(line->str);
+		fprintf(fp, "%s\n", line->str);
 		line = line->above;
 	}
 
-	while ((e = e->cause)) {
-		fprintf(fp, "Caused by: (%d) %s\n", e->code, e->msg);
-		struct exception_line_st *line = e->bottom;
-		while (line) {
-			puts(line->str);
-			line = line->above;
-		}
+	size_t count = get_child_count(e);
+	for (size_t i = 0; i < count; i++) {
+		fprintf(fp, "Failure %zu of %zu: ", i + 1, count);
+		fprint_stacktrace(fp, get_child(e, i));
 	}
 }
 
+void fprint_stacktrace(FILE *fp, Exception e) {
+	if (!e || !fp) return;
+
+	fprint_exception(fp, "Exception", e);
+	while ((e = e->cause))
+		fprint_exception(fp, "Caused by", e);
+}
+
 void print_stacktrace(Exception e) {
 	fprint_stacktrace(stdout, e);
 }
 
-Exception new_exception(char const *msg, int code, Exception cause) {
-	if (!msg) return NULL;
-
-	Exception e = malloc(sizeof *e);
-	if (!e) return NULL;
-
+static void init_exception(Exception e, char const *msg, int code,
+                           Exception cause) {
 	e->msg = msg;
 	e->code = code;
+	e->error = 0;
+	e->msg_kind = MSG_BORROWED;
+	e->detail = NULL;
+	e->detail_kind = MSG_BORROWED;
+	e->fields.count = 0;
+	e->context_count = dare_context.depth < DARE_CONTEXT_MAX
+	                 ? dare_context.depth : DARE_CONTEXT_MAX;
+	memcpy(e->context, dare_context.entries,
+	       e->context_count * sizeof *e->context);
+	e->block = BLOCK_NONE;
+	e->frozen = THAWED;
+	atomic_init(&e->refs, 1);
+	e->depth = cause ? cause->depth + 1 : 1;
+	e->root = cause ? cause->root : e;
+	e->fingerprint = hash(FNV_OFFSET, &code, sizeof code);
+	if (cause)
+		e->fingerprint = hash(e->fingerprint, &cause->fingerprint,
+		                      sizeof cause->fingerprint);
+	e->transient = 0;
+	e->aggregate = NULL;
+	e->attempts = 0;
+	e->retry_after = 0;
 	e->cause = cause;
 	e->top = NULL;
 	e->bottom = NULL;
+	e->line_count = 0;
+}
+
+Exception new_exception(char const *msg, int code, Exception cause) {
+	if (!msg) return NULL;
+
+	Exception e = alloc_exception();
+	if (!e) return NULL;
+
+	init_exception(e, msg, code, cause);
+	return e;
+}
+
+/*
+ * Format the message of an Exception into its text buffer or, if it does not
+ * fit, into the heap. When the heap is exhausted the message is truncated.
+ */
+static void format_msg(Exception e, char const *fmt, va_list ap) {
+	va_list copy;
+	va_copy(copy, ap);
+	int len = vsnprintf(e->text, sizeof e->text, fmt, copy);
+	va_end(copy);
+
+	e->msg = e->text;
+	e->msg_kind = MSG_INLINE;
+	if (len < 0 || (size_t) len < sizeof e->text) return;
+
+	char *heap = malloc(len + 1);
+	if (!heap) return;
+	vsnprintf(heap, len + 1, fmt, ap);
+	e->msg = heap;
+	e->msg_kind = MSG_HEAP;
+}
+
+static Exception vnew_exceptionf(int code, Exception cause, char const *fmt,
+                                 va_list ap) {
+	Exception e = new_exception(fmt, code, cause);
+	if (!e) return NULL;
+
+	format_msg(e, fmt, ap);
 	return e;
 }
 
+Exception new_exceptionf(int code, Exception cause, char const *fmt, ...) {
+	va_list ap;
+	va_start(ap, fmt);
+	Exception e = vnew_exceptionf(code, cause, fmt, ap);
+	va_end(ap);
+	return e;
+}
+
+static void capture(struct lazy_msg *l, int count,
+                    struct dare_arg const *args) {
+	l->count = count;
+	for (int i = 0; i < count; i++) {
+		l->kinds[i] = args[i].kind;
+		l->values[i] = args[i].value;
+	}
+}
+
+Exception new_exception_lazy(int code, Exception cause, char const *fmt,
+                             int count, struct dare_arg const *args) {
+	if (count < 0 || count > DARE_LAZY_ARGS || (count && !args)) return NULL;
+
+	Exception e = new_exception(fmt, code, cause);
+	if (!e) return NULL;
+
+	e->msg_kind = MSG_LAZY;
+	capture(&e->lazy, count, args);
+	return e;
+}
+
+Exception new_exception_owned(char const *msg, int code, Exception cause) {
+	return new_exceptionf(code, cause, "%s", msg);
+}
+
 Exception add_line(Exception e, char const *str) {
 	if (!e) return NULL;
+	if (e->frozen) return e;
 
-	struct exception_line_st *line = malloc(sizeof *line);
+	struct exception_line_st *line = e->line_count < DARE_INLINE_LINES
+	                               ? &e->lines[e->line_count++]
+	                               : malloc(sizeof *line);
 	if (!line) return NULL;
 
+	e->fingerprint = hash(e->fingerprint, str, strlen(str));
 	line->str = str;
 	line->above = NULL;
 	line->below = e->top;
@@ -111,12 +785,817 @@ Exception add_line(Exception e, char const *str) {
 	return e;
 }
 
-void cancel(Exception e) {
-	if (!e) return;
+// The children of an aggregate Exception and the memory their copies live in.
+struct aggregate_st {
+	size_t count;
+	size_t capacity;
+	Exception *children;
+	struct arena_st *arena;
+};
+
+static void free_aggregate(struct aggregate_st *aggregate);
+
+// Free the aggregates owned by the members of a chain.
+static void free_aggregates(Exception e) {
+	for (; e; e = e->cause)
+		if (e->aggregate) free_aggregate(e->aggregate);
+}
+
+// Free a single Exception, whether it is shared or not.
+static void destroy(Exception e) {
+	if (!e || e->block == BLOCK_MEMBER || !claim_exception(e)) return;
+	if (e->block == BLOCK_HEAD) {
+		free_aggregates(e);
+		free(e);
+		return;
+	}
 	while (e->top) {
 		struct exception_line_st *garbage = e->top;
 		e->top = e->top->below;
-		free(garbage);
+		if (garbage < e->lines || garbage >= e->lines + DARE_INLINE_LINES)
+			free(garbage);
+	}
+	if (e->msg_kind == MSG_HEAP) free((char *) e->msg);
+	if (e->detail_kind == MSG_HEAP) free((char *) e->detail);
+	if (e->aggregate) free_aggregate(e->aggregate);
+	release_exception(e);
+}
+
+void cancel(Exception e) {
+	if (e && e->frozen == FROZEN_FOREVER) return;
+	if (e && e->frozen && atomic_fetch_sub_explicit(&e->refs, 1,
+	                                                memory_order_acq_rel) != 1)
+		return;
+	destroy(e);
+}
+
+static void freeze(Exception e) {
+	for (; e && !e->frozen; e = e->cause) {
+		get_msg(e);
+		get_detail(e);
+		size_t count = get_child_count(e);
+		for (size_t i = 0; i < count; i++) freeze(get_child(e, i));
+		e->frozen = FROZEN;
+	}
+}
+
+/*
+ * A frozen Exception holds a reference to its cause, which is dropped when it
+ * is freed. The causes frozen along with it start with that single reference.
+ */
+Exception dare_retain(Exception e) {
+	if (!e || e->frozen == FROZEN_FOREVER) return e;
+	if (!e->frozen) {
+		freeze(e);
+		atomic_store_explicit(&e->refs, 2, memory_order_relaxed);
+	} else {
+		atomic_fetch_add_explicit(&e->refs, 1, memory_order_relaxed);
+	}
+	return e;
+}
+
+void dare_release(Exception e) {
+	while (e && e->frozen != FROZEN_FOREVER) {
+		if (e->frozen && atomic_fetch_sub_explicit(&e->refs, 1,
+		                                           memory_order_acq_rel) != 1)
+			return;
+		Exception cause = e->block == BLOCK_HEAD ? NULL : e->cause;
+		destroy(e);
+		e = cause;
+	}
+}
+
+Exception dare_retain_forever(Exception e) {
+	freeze(e);
+	if (e) e->frozen = FROZEN_FOREVER;
+	return e;
+}
+
+int is_frozen(Exception e) {
+	return e && e->frozen;
+}
+
+/*
+ * Copies of Exceptions are bump allocated from arenas: a single block sized
+ * beforehand for compact(), or a list of blocks growing twice as large each
+ * time for aggregates, so the copies never move.
+ */
+struct arena_st {
+	struct arena_st *next;
+	char *free;
+	char *end;
+};
+
+#define ARENA_ALIGN _Alignof(struct exception_st)
+#define ARENA_ROUND(SIZE) (((SIZE) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+#define ARENA_FIRST 4096
+
+static void *arena_alloc(struct arena_st **arena, size_t size, int grow) {
+	struct arena_st *a = *arena;
+	size = ARENA_ROUND(size);
+	if (a && (size_t) (a->end - a->free) >= size) {
+		void *memory = a->free;
+		a->free += size;
+		return memory;
+	}
+	if (!grow) return NULL;
+
+	size_t capacity = a ? 2 * (size_t) (a->end - (char *) a) : ARENA_FIRST;
+	while (capacity < ARENA_ROUND(sizeof *a) + size) capacity *= 2;
+	struct arena_st *next = malloc(capacity);
+	if (!next) return NULL;
+	next->next = a;
+	next->free = (char *) next + ARENA_ROUND(sizeof *next);
+	next->end = (char *) next + capacity;
+	*arena = next;
+	return arena_alloc(arena, size, 0);
+}
+
+// Point a copied message or detail to the copied text buffer or to a copy of
+// it in the arena, returning zero if the arena is exhausted.
+static int copy_text(char const **str, enum msg_kind *kind,
+                             char *text, struct arena_st **arena, int grow) {
+	if (*kind == MSG_INLINE) {
+		*str = text;
+	} else if (*kind == MSG_HEAP) {
+		size_t len = strlen(*str) + 1;
+		char *copy = arena_alloc(arena, len, grow);
+		if (!copy) return 0;
+		*str = memcpy(copy, *str, len);
+		*kind = MSG_BORROWED;
+	}
+	return 1;
+}
+
+/*
+ * Copy an Exception and its causes into an arena. The first copy is marked
+ * as head, the others as members, and the aggregates of the originals are
+ * handed over to the copies.
+ */
+static Exception copy_chain(Exception e, struct arena_st **arena, int grow,
+                            enum block_kind head) {
+	Exception first = NULL, last = NULL;
+	Exception c;
+	for (c = e; c; c = c->cause) {
+		get_msg(c);
+		get_detail(c);
+		Exception copy = arena_alloc(arena, sizeof *copy, grow);
+		if (!copy) return NULL;
+		*copy = *c;
+		copy->block = first ? BLOCK_MEMBER : head;
+		copy->frozen = THAWED;
+		atomic_init(&copy->refs, 1);
+		copy->cause = NULL;
+		if (c->frozen) copy->aggregate = NULL;
+		if (!copy_text(&copy->msg, &copy->msg_kind, copy->text, arena, grow)
+		    || !copy_text(&copy->detail, &copy->detail_kind, copy->text, arena,
+		                  grow))
+			return NULL;
+
+		copy->top = NULL;
+		copy->bottom = NULL;
+		copy->line_count = 0;
+		struct exception_line_st *line;
+		for (line = c->bottom; line; line = line->above) {
+			struct exception_line_st *line_copy =
+				arena_alloc(arena, sizeof *line_copy, grow);
+			if (!line_copy) return NULL;
+			line_copy->str = line->str;
+			line_copy->above = NULL;
+			line_copy->below = copy->top;
+			if (copy->top)
+				copy->top->above = line_copy;
+			else
+				copy->bottom = line_copy;
+			copy->top = line_copy;
+		}
+
+		if (last)
+			last->cause = copy;
+		else
+			first = copy;
+		last = copy;
+	}
+
+	for (c = first; c; c = c->cause) c->root = last;
+	for (c = e; c && !c->frozen; c = c->cause) c->aggregate = NULL;
+	return first;
+}
+
+Exception compact(Exception e) {
+	if (!e || e->block == BLOCK_HEAD || e->frozen) return e;
+
+	size_t size = 0;
+	Exception c;
+	struct exception_line_st *line;
+	for (c = e; c; c = c->cause) {
+		get_msg(c);
+		get_detail(c);
+		size += ARENA_ROUND(sizeof *c);
+		for (line = c->top; line; line = line->below)
+			size += ARENA_ROUND(sizeof *line);
+		if (c->msg_kind == MSG_HEAP) size += ARENA_ROUND(strlen(c->msg) + 1);
+		if (c->detail_kind == MSG_HEAP)
+			size += ARENA_ROUND(strlen(c->detail) + 1);
+	}
+
+	char *block = malloc(size);
+	if (!block) return e;
+	struct arena_st arena = { NULL, block, block + size };
+	struct arena_st *a = &arena;
+	Exception copy = copy_chain(e, &a, 0, BLOCK_HEAD);
+	dare_release(e);
+	return copy;
+}
+
+/*
+ * Serialization. A chain is encoded as "DX", a version byte and the number of
+ * Exceptions, followed by each one from the outermost:
+ *
+ *   code (zigzag varint), flags (varint), errno (varint),
+ *   retry after (varint, if transient), fingerprint (8 bytes),
+ *   message, detail (if any), fields, lines (from the first added)
+ *
+ * Strings are a varint length followed by the bytes and a zero, so views can
+ * point to them in place. Fields and lines are a varint count followed by
+ * each one, a field being its key, its kind (1 byte) and its value: a zigzag
+ * varint, the 8 bytes of a double, a string or a varint address.
+ */
+#define WIRE_VERSION 1
+
+enum {
+	WIRE_TRANSIENT = 1,
+	WIRE_DETAIL = 2,
+};
+
+// Output of the encoder, which counts what does not fit like snprintf().
+struct writer {
+	unsigned char *out;
+	size_t size;
+	size_t used;
+};
+
+static void write_bytes(struct writer *w, void const *data, size_t len) {
+	if (len && w->used <= w->size && len <= w->size - w->used)
+		memcpy(w->out + w->used, data, len);
+	w->used += len;
+}
+
+static void write_varint(struct writer *w, uint64_t v) {
+	unsigned char bytes[10];
+	size_t len = 0;
+	do {
+		bytes[len++] = (v & 0x7f) | (v > 0x7f ? 0x80 : 0);
+		v >>= 7;
+	} while (v);
+	write_bytes(w, bytes, len);
+}
+
+static void write_fixed(struct writer *w, uint64_t v) {
+	unsigned char bytes[8];
+	for (int i = 0; i < 8; i++) bytes[i] = v >> 8 * i;
+	write_bytes(w, bytes, sizeof bytes);
+}
+
+static void write_str(struct writer *w, char const *str) {
+	size_t len = strlen(str);
+	write_varint(w, len);
+	write_bytes(w, str, len + 1);
+}
+
+static uint64_t zigzag(int64_t v) {
+	return (uint64_t) v << 1 ^ (uint64_t) (v >> 63);
+}
+
+static int64_t unzigzag(uint64_t v) {
+	return (int64_t) (v >> 1) ^ -(int64_t) (v & 1);
+}
+
+static void write_field(struct writer *w, struct fields_st const *f, int i) {
+	unsigned char kind = f->kinds[i];
+	write_str(w, f->keys[i]);
+	write_bytes(w, &kind, 1);
+	switch (kind) {
+	case DARE_FIELD_INT:
+		write_varint(w, zigzag(f->values[i].i));
+		break;
+	case DARE_FIELD_DOUBLE: {
+		uint64_t bits;
+		memcpy(&bits, &f->values[i].d, sizeof bits);
+		write_fixed(w, bits);
+		break;
+	}
+	case DARE_FIELD_STR:
+		write_str(w, f->values[i].s);
+		break;
+	default:
+		write_varint(w, (uintptr_t) f->values[i].p);
+		break;
+	}
+}
+
+size_t dare_serialize(Exception e, void *buf, size_t size) {
+	if (!e) return 0;
+
+	struct writer w = { buf, buf ? size : 0, 0 };
+	unsigned char version = WIRE_VERSION;
+	uint64_t count = 0;
+	Exception c;
+	for (c = e; c; c = c->cause) count++;
+	write_bytes(&w, "DX", 2);
+	write_bytes(&w, &version, 1);
+	write_varint(&w, count);
+
+	for (c = e; c; c = c->cause) {
+		char const *msg = get_msg(c);
+		char const *detail = get_detail(c);
+		write_varint(&w, zigzag(c->code));
+		write_varint(&w, (c->transient ? WIRE_TRANSIENT : 0)
+		                 | (detail ? WIRE_DETAIL : 0));
+		write_varint(&w, (unsigned) c->error);
+		if (c->transient) write_varint(&w, c->retry_after);
+		write_fixed(&w, c->fingerprint);
+		write_str(&w, msg);
+		if (detail) write_str(&w, detail);
+
+		write_varint(&w, c->fields.count);
+		for (int i = 0; i < c->fields.count; i++)
+			write_field(&w, &c->fields, i);
+
+		struct exception_line_st *line;
+		uint64_t lines = 0;
+		for (line = c->bottom; line; line = line->above) lines++;
+		write_varint(&w, lines);
+		for (line = c->bottom; line; line = line->above)
+			write_str(&w, line->str);
+	}
+	return w.used;
+}
+
+// Input of the decoder, which checks every read against the end.
+struct reader {
+	unsigned char const *p;
+	unsigned char const *end;
+};
+
+static int read_varint(struct reader *r, uint64_t *v) {
+	uint64_t value = 0;
+	for (int shift = 0; shift < 64 && r->p < r->end; shift += 7) {
+		unsigned char byte = *r->p++;
+		value |= (uint64_t) (byte & 0x7f) << shift;
+		if (!(byte & 0x80)) {
+			*v = value;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int read_fixed(struct reader *r, uint64_t *v) {
+	if (r->end - r->p < 8) return 0;
+	*v = 0;
+	for (int i = 0; i < 8; i++) *v |= (uint64_t) r->p[i] << 8 * i;
+	r->p += 8;
+	return 1;
+}
+
+static int read_str(struct reader *r, char const **str) {
+	uint64_t len;
+	if (!read_varint(r, &len) || len >= (uint64_t) (r->end - r->p) || r->p[len])
+		return 0;
+	*str = (char const *) r->p;
+	r->p += len + 1;
+	return 1;
+}
+
+// Read a field, whose string value points into the buffer, returning its kind.
+static int read_field(struct reader *r, char const **key,
+                      union dare_value *value) {
+	uint64_t v;
+	char const *str;
+	if (!read_str(r, key) || r->p == r->end) return -1;
+	int kind = *r->p++;
+	switch (kind) {
+	case DARE_FIELD_INT:
+		if (!read_varint(r, &v)) return -1;
+		value->i = unzigzag(v);
+		return kind;
+	case DARE_FIELD_DOUBLE:
+		if (!read_fixed(r, &v)) return -1;
+		memcpy(&value->d, &v, sizeof v);
+		return kind;
+	case DARE_FIELD_STR:
+		if (!read_str(r, &str) || strlen(str) >= DARE_FIELD_STR_SIZE) return -1;
+		value->p = str;
+		return kind;
+	case DARE_FIELD_PTR:
+		if (!read_varint(r, &v)) return -1;
+		value->p = (void const *) (uintptr_t) v;
+		return kind;
+	default:
+		return -1;
+	}
+}
+
+static int read_record(struct reader *r, struct dare_record *rec) {
+	uint64_t code, flags, error, retry_after = 0, count;
+	char const *str;
+	union dare_value value;
+	if (!read_varint(r, &code) || !read_varint(r, &flags)
+	    || !read_varint(r, &error)
+	    || ((flags & WIRE_TRANSIENT) && !read_varint(r, &retry_after))
+	    || !read_fixed(r, &rec->fingerprint) || !read_str(r, &rec->msg))
+		return 0;
+	rec->detail = NULL;
+	if ((flags & WIRE_DETAIL) && !read_str(r, &rec->detail)) return 0;
+
+	if (!read_varint(r, &count) || count > DARE_FIELDS) return 0;
+	rec->field_count = count;
+	rec->fields = r->p;
+	for (uint64_t i = 0; i < count; i++)
+		if (read_field(r, &str, &value) < 0) return 0;
+
+	if (!read_varint(r, &count) || count > (uint64_t) (r->end - r->p)) return 0;
+	rec->line_count = count;
+	rec->lines = r->p;
+	for (uint64_t i = 0; i < count; i++)
+		if (!read_str(r, &str)) return 0;
+
+	rec->code = (int) unzigzag(code);
+	rec->error = (int) error;
+	rec->transient = flags & WIRE_TRANSIENT;
+	rec->retry_after = (int64_t) retry_after;
+	rec->end = r->p;
+	return 1;
+}
+
+int dare_view_open(struct dare_view *v, void const *buf, size_t size) {
+	if (!v || !buf) return -1;
+
+	struct reader r = { buf, (unsigned char const *) buf + size };
+	struct dare_record rec;
+	uint64_t count;
+	if (size < 3 || memcmp(buf, "DX", 2) || r.p[2] != WIRE_VERSION) return -1;
+	r.p += 3;
+	if (!read_varint(&r, &count) || !count || count > size) return -1;
+
+	v->next = r.p;
+	for (uint64_t i = 0; i < count; i++)
+		if (!read_record(&r, &rec)) return -1;
+	v->end = r.p;
+	v->remaining = count;
+	return 0;
+}
+
+int dare_view_next(struct dare_view *v, struct dare_record *rec) {
+	if (!v || !rec || !v->remaining) return 0;
+
+	struct reader r = { v->next, v->end };
+	read_record(&r, rec);
+	v->next = r.p;
+	v->remaining--;
+	return 1;
+}
+
+int dare_record_field(struct dare_record const *rec, int index,
+                      char const **key, union dare_value *value) {
+	if (!rec || index < 0 || index >= rec->field_count) return -1;
+
+	struct reader r = { rec->fields, rec->end };
+	char const *k;
+	union dare_value v;
+	int kind;
+	for (int i = 0; i <= index; i++) kind = read_field(&r, &k, &v);
+	if (key) *key = k;
+	if (value) *value = v;
+	return kind;
+}
+
+char const *dare_record_line(struct dare_record const *rec, int index) {
+	if (!rec || index < 0 || index >= rec->line_count) return NULL;
+
+	struct reader r = { rec->lines, rec->end };
+	char const *str = NULL;
+	for (int i = 0; i <= index; i++) read_str(&r, &str);
+	return str;
+}
+
+// Build an Exception in an arena from a record whose strings it points to.
+static Exception build_record(struct dare_record const *rec,
+                              struct arena_st **arena, enum block_kind block) {
+	Exception e = arena_alloc(arena, sizeof *e, 0);
+	init_exception(e, rec->msg, rec->code, NULL);
+	e->context_count = 0;
+	e->block = block;
+	e->error = rec->error;
+	e->transient = rec->transient;
+	e->retry_after = rec->retry_after;
+	e->fingerprint = rec->fingerprint;
+	e->detail = rec->detail;
+
+	struct fields_st *f = &e->fields;
+	struct reader r = { rec->fields, rec->end };
+	union dare_value value;
+	for (f->count = 0; f->count < rec->field_count; f->count++) {
+		int i = f->count;
+		f->kinds[i] = read_field(&r, &f->keys[i], &value);
+		if (f->kinds[i] == DARE_FIELD_STR)
+			strcpy(f->values[i].s, value.p);
+		else if (f->kinds[i] == DARE_FIELD_DOUBLE)
+			f->values[i].d = value.d;
+		else if (f->kinds[i] == DARE_FIELD_INT)
+			f->values[i].i = value.i;
+		else
+			f->values[i].p = value.p;
+	}
+
+	r.p = rec->lines;
+	for (int i = 0; i < rec->line_count; i++) {
+		struct exception_line_st *line = arena_alloc(arena, sizeof *line, 0);
+		read_str(&r, &line->str);
+		line->above = NULL;
+		line->below = e->top;
+		if (e->top)
+			e->top->above = line;
+		else
+			e->bottom = line;
+		e->top = line;
+	}
+	return e;
+}
+
+/*
+ * The bytes are copied to the end of a block sized beforehand, like the one
+ * made by compact(), and the Exceptions built at its start point into them.
+ */
+Exception dare_deserialize(void const *buf, size_t size) {
+	struct dare_view v;
+	struct dare_record rec;
+	if (dare_view_open(&v, buf, size) < 0) return NULL;
+
+	size_t used = v.end - (unsigned char const *) buf;
+	size_t bytes = ARENA_ROUND(used);
+	while (dare_view_next(&v, &rec))
+		bytes += ARENA_ROUND(sizeof (struct exception_st))
+		       + rec.line_count * ARENA_ROUND(sizeof (struct exception_line_st));
+
+	char *block = malloc(bytes);
+	if (!block) return NULL;
+	char *copy = memcpy(block + bytes - ARENA_ROUND(used), buf, used);
+	struct arena_st arena = { NULL, block, copy };
+	struct arena_st *a = &arena;
+	dare_view_open(&v, copy, used);
+
+	Exception first = NULL, last = NULL, c;
+	while (dare_view_next(&v, &rec)) {
+		c = build_record(&rec, &a, first ? BLOCK_MEMBER : BLOCK_HEAD);
+		if (last)
+			last->cause = c;
+		else
+			first = c;
+		last = c;
+	}
+
+	int depth = 0;
+	for (c = first; c; c = c->cause) depth++;
+	for (c = first; c; c = c->cause) {
+		c->depth = depth--;
+		c->root = last;
+	}
+	return first;
+}
+
+static void free_aggregate(struct aggregate_st *aggregate) {
+	for (size_t i = 0; i < aggregate->count; i++)
+		free_aggregates(aggregate->children[i]);
+	while (aggregate->arena) {
+		struct arena_st *next = aggregate->arena->next;
+		free(aggregate->arena);
+		aggregate->arena = next;
+	}
+	free(aggregate->children);
+	free(aggregate);
+}
+
+Exception new_aggregate(char const *msg, int code) {
+	struct aggregate_st *aggregate = calloc(1, sizeof *aggregate);
+	if (!aggregate) return NULL;
+
+	Exception e = new_exception(msg, code, NULL);
+	if (!e) {
+		free(aggregate);
+		return NULL;
+	}
+	e->aggregate = aggregate;
+	return e;
+}
+
+int aggregate_add(Exception aggregate, Exception child) {
+	if (!child) return -1;
+	if (!aggregate || !aggregate->aggregate || aggregate->frozen
+	    || aggregate == child) {
+		dare_release(child);
+		return -1;
 	}
-	free(e);
-}
\ No newline at end of file
+
+	struct aggregate_st *a = aggregate->aggregate;
+	if (a->count == a->capacity) {
+		size_t capacity = a->capacity ? 2 * a->capacity : 16;
+		Exception *children = realloc(a->children, capacity * sizeof *children);
+		if (!children) {
+			dare_release(child);
+			return -1;
+		}
+		a->children = children;
+		a->capacity = capacity;
+	}
+
+	Exception copy = copy_chain(child, &a->arena, 1, BLOCK_MEMBER);
+	dare_release(child);
+	if (!copy) return -1;
+	a->children[a->count++] = copy;
+	return 0;
+}
+
+size_t get_child_count(Exception e) {
+	if (!e || !e->aggregate) return 0;
+	return e->aggregate->count;
+}
+
+Exception get_child(Exception e, size_t index) {
+	if (!e || !e->aggregate || index >= e->aggregate->count) return NULL;
+	return e->aggregate->children[index];
+}
+
+Exception dare_collect(Exception all, Exception e, size_t index) {
+	if (!all) {
+		all = new_aggregate(DARE_AGGREGATE_MSG, DARE_AGGREGATE_EXCEPTION);
+		if (!all) return e;
+	}
+	dare_set_int(e, "index", (int64_t) index);
+	aggregate_add(all, e);
+	return all;
+}
+
+Exception set_transient(Exception e, int64_t retry_after_ns) {
+	if (!e) return NULL;
+	if (e->frozen) return e;
+	e->transient = 1;
+	e->retry_after = retry_after_ns > 0 ? retry_after_ns : 0;
+	return e;
+}
+
+int is_transient(Exception e) {
+	if (!e) return 0;
+	return e->transient;
+}
+
+int64_t get_retry_after(Exception e) {
+	if (!e) return 0;
+	return e->retry_after;
+}
+
+int get_attempts(Exception e) {
+	if (!e) return 0;
+	return e->attempts;
+}
+
+static int64_t monotonic_ns(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (int64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+// A xorshift generator for the jitter, seeded on its first use by each thread.
+static _Thread_local uint64_t jitter_state;
+
+static uint64_t jitter(uint64_t bound) {
+	uint64_t x = jitter_state;
+	if (!x) x = (uint64_t) monotonic_ns() ^ (uintptr_t) &jitter_state ^ 1;
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	jitter_state = x;
+	return bound ? x % bound : 0;
+}
+
+int dare_retry_again(struct dare_retry *retry, Exception e) {
+	struct dare_retry_policy const *policy = retry->policy;
+	retry->attempt++;
+	if (!e->frozen) e->attempts = retry->attempt;
+	if (!e->transient || retry->attempt >= policy->max_attempts) return 0;
+
+	int64_t delay = policy->base_ns;
+	for (int i = 1; i < retry->attempt && delay < policy->max_ns; i++)
+		delay *= 2;
+	if (delay > policy->max_ns) delay = policy->max_ns;
+	if (delay > 0) delay = delay / 2 + jitter(delay / 2 + 1);
+	if (delay < e->retry_after) delay = e->retry_after;
+	dare_release(e);
+
+	if (!retry->deadline) retry->deadline = monotonic_ns();
+	retry->deadline += delay;
+	struct timespec deadline = {
+		retry->deadline / 1000000000, retry->deadline % 1000000000
+	};
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL)
+	       == EINTR)
+		continue;
+	return 1;
+}
+
+ExceptionHandle get_handle(Exception e) {
+	struct slot_st *slot = slot_of(e);
+	if (!slot) return NULL_HANDLE;
+
+	uint32_t generation = atomic_load_explicit(&slot->generation,
+	                                           memory_order_acquire);
+	if (!(generation & 1)) return NULL_HANDLE;
+	return (generation & GENERATION_MASK) << DARE_SLOT_BITS
+	     | (uint32_t) (slot - slots);
+}
+
+Exception from_handle(ExceptionHandle h) {
+	if (h == NULL_HANDLE) return NULL;
+
+	struct slot_st *slot = &slots[h & (DARE_SLOTS - 1)];
+	uint32_t generation = atomic_load_explicit(&slot->generation,
+	                                           memory_order_acquire);
+	if (!(generation & 1) || (generation & GENERATION_MASK) != h >> DARE_SLOT_BITS)
+		return NULL;
+	return &slot->exception;
+}
+
+void cancel_handle(ExceptionHandle h) {
+	cancel(from_handle(h));
+}
+
+Exception dare_throw(char const *msg, int code, char const *line) {
+	return add_line(new_exception(msg, code, NULL), line);
+}
+
+Exception dare_rethrow(Exception e, char const *line) {
+	return add_line(e, line);
+}
+
+Exception dare_throw_cause(Exception cause, char const *msg, int code,
+                           char const *line) {
+	return add_line(new_exception(msg, code, cause), line);
+}
+
+Exception dare_throwf(char const *line, int code, char const *fmt, ...) {
+	va_list ap;
+	va_start(ap, fmt);
+	Exception e = vnew_exceptionf(code, NULL, fmt, ap);
+	va_end(ap);
+	return add_line(e, line);
+}
+
+Exception dare_throw_causef(Exception cause, char const *line, int code,
+                            char const *fmt, ...) {
+	va_list ap;
+	va_start(ap, fmt);
+	Exception e = vnew_exceptionf(code, cause, fmt, ap);
+	va_end(ap);
+	return add_line(e, line);
+}
+
+Exception dare_throw_lazy(char const *line, int code, char const *fmt,
+                          int count, struct dare_arg const *args) {
+	return add_line(new_exception_lazy(code, NULL, fmt, count, args), line);
+}
+
+Exception dare_throw_detail(char const *msg, int code, char const *line,
+                            char const *fmt, int count,
+                            struct dare_arg const *args) {
+	if (count < 0 || count > DARE_LAZY_ARGS || (count && !args)) return NULL;
+
+	Exception e = new_exception(msg, code, NULL);
+	if (!e) return NULL;
+
+	e->detail = fmt;
+	e->detail_kind = MSG_LAZY;
+	capture(&e->lazy, count, args);
+	return add_line(e, line);
+}
+
+Exception dare_throw_errno(char const *expr, int error, char const *line) {
+	Exception e = new_exception(expr, DARE_ERRNO_EXCEPTION, NULL);
+	if (!e) return NULL;
+
+	e->error = error;
+	e->msg_kind = MSG_ERRNO;
+	e->fingerprint = hash(e->fingerprint, &error, sizeof error);
+	return add_line(e, line);
+}
+
+int get_errno(Exception e) {
+	if (!e) return 0;
+	return e->error;
+}
+
+Exception dare_throw_cause_lazy(Exception cause, char const *line, int code,
+                                char const *fmt, int count,
+                                struct dare_arg const *args) {
+	return add_line(new_exception_lazy(code, cause, fmt, count, args), line);
+}
@@ -25,7 +25,10 @@ SOFTWARE.
 #define DARE_H
 #include <stdio.h>
 #include <stdlib.h>
+#include <setjmp.h>
+#include <stdint.h>
 #include <string.h>
+#include <errno.h>
 
 //! An struture representing an exception
 typedef struct exception_st * Exception;
@@ -45,6 +48,42 @@ typedef struct exception_st * Exception;
  */
 Exception new_exception(char const *msg, int code, Exception cause);
 
+/*!
+ * Construct a new Exception that owns a copy of its message.
+ *
+ * Messages shorter than DARE_INLINE_MSG bytes are stored inside the Exception
+ * itself, longer ones are copied to the heap.
+ *
+ * \param msg   The message describing the Exception, it may be freed later.
+ * \param code  An integer code representing the Exception class.
+ * \param cause Another optional Exception that caused this new Exception, or
+ * NULL, in case there is none.
+ * \return      The new Exception created or NULL in case of error.
+ */
+Exception new_exception_owned(char const *msg, int code, Exception cause);
+
+/*!
+ * Construct a new Exception whose message is formatted like printf().
+ *
+ * The message is owned by the Exception like in new_exception_owned(). Try
+ * not to call this function directly, use the macros throwf() or
+ * check_causef() instead.
+ *
+ * \param code  An integer code representing the Exception class.
+ * \param cause Another optional Exception that caused this new Exception, or
+ * NULL, in case there is none.
+ * \param fmt   The format of the message, followed by its arguments.
+ * \return      The new Exception created or NULL in case of error.
+ */
+Exception new_exceptionf(int code, Exception cause, char const *fmt, ...)
+  __attribute__((format(printf, 3, 4)));
+
+//! The size of the buffer inside each Exception for short owned messages.
+#define DARE_INLINE_MSG 48
+
+//! How many lines of its stacktrace each Exception holds before the heap.
+#define DARE_INLINE_LINES 4
+
 /*!
  * Add one line to the stacktrace of the given Exception.
  *
@@ -65,6 +104,17 @@ Exception add_line(Exception e, char const *str);
  */
 char const *get_msg(Exception e);
 
+/*!
+ * Extract the detail of an Exception, a line explaining why it was thrown
+ * that is formatted only when first read. The comparison assertions set it
+ * to the expressions and values compared, like "expected x == 8, got 7 vs
+ * 8".
+ *
+ * \param e The Exception whose detail will be extracted.
+ * \return  The detail or NULL if it has none.
+ */
+char const *get_detail(Exception e);
+
 /*!
  * Extract the code from an Exception.
  *
@@ -82,6 +132,120 @@ int get_code(Exception e);
  */
 Exception get_cause(Exception e);
 
+/*!
+ * Return the deepest Exception of the chain of causes of an Exception.
+ *
+ * The root cause is recorded when an Exception is created, so this takes
+ * constant time whatever the length of the chain.
+ *
+ * \param e The Exception whose root cause is to be extracted.
+ * \return  The root cause, e itself if it has no cause, or NULL if e is NULL.
+ */
+Exception get_root_cause(Exception e);
+
+/*!
+ * Return the length of the chain of causes of an Exception, in constant time.
+ *
+ * \param e The Exception whose chain is measured.
+ * \return  1 for an Exception without cause, 1 plus the depth of its cause
+ * otherwise, or 0 if e is NULL.
+ */
+int get_depth(Exception e);
+
+/*!
+ * Find the first Exception with a code in the chain of causes of an
+ * Exception, starting from the Exception itself.
+ *
+ * \param e    The Exception whose chain is searched.
+ * \param code The code searched for.
+ * \return     The Exception found or NULL if there is none.
+ */
+Exception find_cause_by_code(Exception e, int code);
+
+/*!
+ * Return a 64 bit fingerprint identifying where an Exception comes from.
+ *
+ * The fingerprint is computed incrementally from the code, the fingerprint
+ * of the cause when it was wrapped and every line added, so it is the same
+ * for Exceptions thrown by the same site and propagated along the same path,
+ * whatever their messages, and it does not change between runs. It can key
+ * hash tables and counters without walking the chain.
+ *
+ * \param e The Exception whose fingerprint is returned.
+ * \return  The fingerprint or 0 if e is NULL.
+ */
+uint64_t get_fingerprint(Exception e);
+
+/*!
+ * Tell whether two Exceptions have the same fingerprint, in constant time.
+ *
+ * \return 1 if they have, 0 otherwise or if any of them is NULL.
+ */
+int same_fingerprint(Exception a, Exception b);
+
+/*!
+ * Tell whether two Exceptions are the same error, comparing their codes and
+ * lines along both chains of causes, which rules out fingerprint collisions.
+ *
+ * \return 1 if they are, 0 otherwise or if any of them is NULL.
+ */
+int same_error(Exception a, Exception b);
+
+/*!
+ * Copy an Exception and its chain of causes into a single block of memory.
+ *
+ * The copies keep the messages, lines, fields and context of the originals,
+ * which are cancelled. The block is faster to traverse and cheaper to keep,
+ * and cancelling the compacted Exception frees all of it at once, while
+ * cancelling the causes inside it does nothing.
+ *
+ * \param e The Exception to be compacted with its causes.
+ * \return  The compacted Exception, or e unchanged if there is no memory.
+ */
+Exception compact(Exception e);
+
+/*!
+ * Construct a new aggregate Exception, which holds copies of many other
+ * Exceptions, its children.
+ *
+ * \param msg  The message describing the Exception.
+ * \param code An integer code representing the Exception class.
+ * \return     The new Exception created or NULL in case of error.
+ */
+Exception new_aggregate(char const *msg, int code);
+
+/*!
+ * Add a copy of an Exception and its causes to the children of an aggregate.
+ *
+ * The copies share a few large blocks of memory owned by the aggregate, which
+ * grow as needed, so adding many children takes few allocations. The added
+ * Exception and its causes are cancelled, even if adding fails.
+ *
+ * \param aggregate The aggregate Exception.
+ * \param child     The Exception to be added.
+ * \return          0 on success, -1 if aggregate is not an aggregate or there
+ * is no memory.
+ */
+int aggregate_add(Exception aggregate, Exception child);
+
+/*!
+ * Count the children of an aggregate Exception.
+ *
+ * \return The number of children, 0 if e is not an aggregate.
+ */
+size_t get_child_count(Exception e);
+
+/*!
+ * Return a child of an aggregate Exception, in the order they were added.
+ *
+ * The child belongs to the aggregate, cancelling it does nothing.
+ *
+ * \param e     The aggregate Exception.
+ * \param index The position of the child, from 0 to get_child_count() - 1.
+ * \return      The child or NULL if there is none.
+ */
+Exception get_child(Exception e, size_t index);
+
 /*!
  * Print the Exception's message and stacktrace.
  *
@@ -110,199 +274,2247 @@ void print_stacktrace(Exception e);
  * Just call this function after completely treating the Exception. Do not call
  * it before rethrowing, i.e. returning the Exception.
  *
+ * Only this Exception is freed, never its causes, which are cancelled on their
+ * own. On a shared Exception it drops just its own reference, so a retained
+ * chain is released either this way member by member, or with dare_release()
+ * on its head, but never both.
+ *
  * \param e The Exception to be destroyed.
  */
 void cancel(Exception e);
 
-// Some auxiliary macros
-#define xstr(X) str(X)
-#define str(X) #X
-#define dare_noop ((void)0)
-
-//! Success is indicated by returning a NULL pointer, i.e. no Exception.
-#define SUCCESS NULL
-//! This is the name of the Exception variable, redefine at will.
-#define EVAR dare_exception
+/*
+ * Shared Exceptions.
+ *
+ * An Exception handed to several consumers is reference counted. The first
+ * dare_retain() freezes it with its causes: what is still formatted lazily is
+ * rendered and they cannot be changed anymore, so they can be read from any
+ * thread without locks. Until then the Exception has a single owner and its
+ * count is never touched atomically.
+ */
 
 /*!
- * This macro defines a try clause that receives a BLOCK of code.
+ * Add a reference to an Exception, to hand it to one more consumer.
  *
- * It simply declares the Exception variable and initializes it with SUCCESS.
- * Because of this declaration only one try clause is permitted by each scope.
- * I'd go further and recommend only one for each function.
+ * The first call must be made by the thread owning the Exception, before it
+ * is shared. From then on, add_line() and set_transient() leave it as is,
+ * while compact(), aggregate_add() to it and the setters of fields fail.
  *
- * \example
- * try (
- *     // some code here that may throw Exceptions
- * ) catch (
- *     // some code here that deals with the Exception at EVAR
- * )
+ * \param e The Exception to be shared.
+ * \return  The same Exception.
  */
-#define try(BLOCK) \
-  Exception EVAR = SUCCESS; \
-  BLOCK
+Exception dare_retain(Exception e);
 
 /*!
- * This macro defines a check clause that receives a call to a function that may
- * throw, i.e. return an Exception.
+ * Drop a reference to an Exception. The last one cancels it along with all
+ * its causes, exactly once, unlike cancel() which never touches the causes.
  *
- * This macro should be used only inside a try block and only around functions
- * that may return Exceptions.
+ * \param e The Exception to be released.
+ */
+void dare_release(Exception e);
+
+/*!
+ * Freeze an Exception like dare_retain(), but keep it forever: cancel() and
+ * dare_release() leave it alone, so it can be thrown again and again without
+ * allocating, from any thread. Its causes are kept along with it.
  *
- * \example
- * try (
- *     // suppose division throws if b is zero
- *     check(division(a,b))
- * ) catch (
- *     // deal with the Exception at EVAR
- * )
+ * \param e The Exception to be kept.
+ * \return  The same Exception.
  */
-#define check(EXPR) { \
-  EVAR = EXPR; \
-  if (EVAR != SUCCESS) { \
-    EVAR = add_line(EVAR, "  at " __FILE__ ":" xstr(__LINE__)); \
-    goto dare_failure; \
-  } \
-}
+Exception dare_retain_forever(Exception e);
 
 /*!
- * This macro defines a check clause that checks for an Exception, and throws
- * another one with the first one as its cause.
+ * Check whether an Exception has been frozen by dare_retain() or
+ * dare_retain_forever().
  *
- * This macro should be used only inside a try block and only around functions
- * that may return Exceptions.
+ * \param e The Exception to be checked.
+ * \return  Non zero if it is frozen, zero otherwise.
+ */
+int is_frozen(Exception e);
+
+/*
+ * Exception handles.
  *
- * \example
- * try (
- *     // suppose division throws if b is zero
- *     check_cause(division(a,b), INVALID_OP, "Uh-oh!")
- * ) catch (
- *     // if division throws EVAR has an Exception with cause here
- * )
+ * Exceptions are allocated from a global lock-free table of DARE_SLOTS slots,
+ * falling back to the heap when it is full. A pooled Exception can also be
+ * referred to by a 32 bit handle, made of its slot index and the generation of
+ * the slot. Cancelling bumps the generation, so a stale handle is detected
+ * with one compare and a second cancel() of a pooled Exception is ignored.
  */
-#define check_cause(EXPR, MSG, CODE) { \
-  EVAR = EXPR; \
-  if (EVAR != SUCCESS) check(new_exception(MSG, CODE, EVAR)) \
-}
+#ifndef DARE_SLOT_BITS
+#define DARE_SLOT_BITS 10
+#endif
+#define DARE_SLOTS (1 << DARE_SLOT_BITS)
+
+//! A compact reference to an Exception that detects when it is stale.
+typedef uint32_t ExceptionHandle;
+
+//! The handle that refers to no Exception.
+#define NULL_HANDLE 0
 
 /*!
- * This macro defines a catch clause to deal with a possible Exception thrown
- * from the try block before.
+ * Get the handle of an Exception.
  *
- * Because it declares labels it should be only one catch clause per function
- * immediately following the end of the try block.
+ * \param e The Exception whose handle will be returned.
+ * \return  Its handle or NULL_HANDLE if it was allocated from the heap.
+ */
+ExceptionHandle get_handle(Exception e);
+
+/*!
+ * Get the Exception a handle refers to.
  *
- * \example
- * try (
- *     // suppose a Exception maybe thrown here
- * ) catch (
- *     // it will be accessible here in EVAR
- *     print_stacktrace(EVAR);
- * )
+ * \param h The handle of the Exception.
+ * \return  The Exception or NULL if the handle is stale.
  */
-#define catch(BLOCK) \
-  goto dare_success; \
-dare_failure: \
-  BLOCK \
-dare_success: \
-  dare_noop;
+Exception from_handle(ExceptionHandle h);
 
 /*!
- * This macro throws a new Exception with a message and a class code.
+ * Destroy the Exception a handle refers to, like cancel().
  *
- * This macro must be used only inside a try block. If the exception is to be
- * rethrown by the surrounding function, it must be returned from the catch
- * block.
+ * \param h The handle of the Exception, nothing happens if it is stale.
+ */
+void cancel_handle(ExceptionHandle h);
+
+/*
+ * Structured fields.
  *
- * \example
- * try (
- *     // throw the Exception here
- *     if (answer != 42) throw("Something is wrong", 42)
- * ) catch (
- *     // catch and rethrow it here
- *     return EVAR;
- * )
+ * An Exception holds up to DARE_FIELDS typed key-value pairs in its own
+ * storage, so machine-readable context can be attached without allocating.
+ * Keys are borrowed like messages and are usually string literals, which are
+ * matched by address before being compared.
  */
-#define throw(MSG, CODE) { \
-  EVAR = new_exception(MSG, CODE, NULL); \
-  EVAR = add_line(EVAR, "  at " __FILE__ ":" xstr(__LINE__)); \
-  goto dare_failure; \
-}
+#define DARE_FIELDS 4
+
+//! The size of the buffer of a string field, including its terminator.
+#define DARE_FIELD_STR_SIZE 16
+
+//! The types of the values of fields.
+enum dare_field_kind {
+  DARE_FIELD_INT,
+  DARE_FIELD_DOUBLE,
+  DARE_FIELD_STR,
+  DARE_FIELD_PTR,
+};
 
 /*!
- * This macro throws an Exception with message and class code if its argument
- * is zero (not TRUE).
+ * Set a field with an integer value, replacing any field with the same key.
+ *
+ * \param e     The Exception the field will be attached to.
+ * \param key   The name of the field, which must outlive the Exception.
+ * \param value The value of the field.
+ * \return      0 on success, -1 if e or key is NULL or all fields are used.
  */
-#define assert_true(X, MSG, CODE) { if (!(X)) throw(MSG, CODE) }
+int dare_set_int(Exception e, char const *key, int64_t value);
 
 /*!
- * This macro throws an Exception with message and class code if its argument
- * is not zero (not FALSE).
+ * Set a field with a floating point value, like dare_set_int().
  */
-#define assert_false(X, MSG, CODE) { if (X) throw(MSG, CODE) }
+int dare_set_double(Exception e, char const *key, double value);
 
 /*!
- * This macro throws an Exception with message and class code if its argument
- * is not NULL.
+ * Set a field with a copy of a string, like dare_set_int(). Strings longer
+ * than DARE_FIELD_STR_SIZE - 1 characters are truncated.
  */
-#define assert_null(X, MSG, CODE) { assert_true(X == NULL, MSG, CODE) }
+int dare_set_str(Exception e, char const *key, char const *value);
 
 /*!
- * This macro throws an Exception with message and class code if its argument
- * is NULL.
+ * Set a field with a pointer value, like dare_set_int().
  */
-#define assert_not_null(X, MSG, CODE) { assert_false(X == NULL, MSG, CODE) }
+int dare_set_ptr(Exception e, char const *key, void const *value);
 
 /*!
- * This macro throws an Exception with message and class code if its arguments
- * are not equal.
+ * Get the value of an integer field.
+ *
+ * \param e     The Exception the field is attached to.
+ * \param key   The name of the field.
+ * \param value Where the value is stored if the field is found.
+ * \return      0 on success, -1 if there is no integer field with this key.
  */
-#define assert_equal(X, Y, MSG, CODE) { assert_true(X == Y, MSG, CODE) }
+int dare_get_int(Exception e, char const *key, int64_t *value);
 
 /*!
- * This macro throws an Exception with message and class code if its arguments
- * are equal.
+ * Get the value of a floating point field, like dare_get_int().
  */
-#define assert_not_equal(X, Y, MSG, CODE) { assert_false(X == Y, MSG, CODE) }
+int dare_get_double(Exception e, char const *key, double *value);
 
 /*!
- * This macro throws an Exception with message and class code if its first
- * argument is greater than or equal the second.
+ * Get the value of a string field, like dare_get_int(). The string belongs to
+ * the Exception.
  */
-#define assert_lt(X, Y, MSG, CODE) { assert_true(X < Y, MSG, CODE) }
+int dare_get_str(Exception e, char const *key, char const **value);
 
 /*!
- * This macro throws an Exception with message and class code if its first
- * argument is less than or equal the second.
+ * Get the value of a pointer field, like dare_get_int().
  */
-#define assert_gt(X, Y, MSG, CODE) { assert_true(X > Y, MSG, CODE) }
+int dare_get_ptr(Exception e, char const *key, void const **value);
 
 /*!
- * This macro throws an Exception with message and class code if its first
- * argument is greater than the second.
+ * Count the fields of an Exception.
+ *
+ * \param e The Exception whose fields are counted.
+ * \return  The number of fields, 0 if e is NULL.
  */
-#define assert_le(X, Y, MSG, CODE) { assert_true(X <= Y, MSG, CODE) }
+int dare_field_count(Exception e);
 
 /*!
- * This macro throws an Exception with message and class code if its first
- * argument is less than the second.
+ * Get the key and the type of a field by its position, to list the fields.
+ *
+ * \param e     The Exception the field is attached to.
+ * \param index The position of the field, from 0 to dare_field_count() - 1.
+ * \param key   Where the name of the field is stored.
+ * \return      The dare_field_kind of the field or -1 if there is none.
+ */
+int dare_field_at(Exception e, int index, char const **key);
+
+/*
+ * Thread context.
+ *
+ * Each thread has a small stack of labelled values, like the id of the
+ * request being served or the name of the operation, that is copied into
+ * every Exception created by the thread, so it does not have to be passed to
+ * each throw. Pushing and popping never allocate; beyond DARE_CONTEXT_MAX
+ * entries the deeper ones are counted but not recorded.
+ */
+#define DARE_CONTEXT_MAX 4
+
+//! A labelled value of the context, either an integer or a string.
+struct dare_context_entry {
+  char const *label;
+  char const *str;
+  int64_t value;
+};
+
+struct dare_context {
+  unsigned depth;
+  struct dare_context_entry entries[DARE_CONTEXT_MAX];
+};
+
+//! The context of the calling thread.
+extern _Thread_local struct dare_context dare_context;
+
+/*!
+ * Push a string onto the context of the calling thread.
+ *
+ * \param label The name of the value, usually a string literal.
+ * \param str   The value, which must outlive the Exceptions created while it
+ * is in the context.
  */
-#define assert_ge(X, Y, MSG, CODE) { assert_true(X >= Y, MSG, CODE) }
+static inline void dare_context_push_str(char const *label, char const *str) {
+  unsigned depth = dare_context.depth++;
+  if (depth < DARE_CONTEXT_MAX)
+    dare_context.entries[depth] = (struct dare_context_entry) { label, str, 0 };
+}
 
 /*!
- * This macro throws an Exception with message and class code if its string
- * arguments are not equal.
+ * Push an integer onto the context of the calling thread, like
+ * dare_context_push_str().
  */
-#define assert_str_equal(X, Y, MSG, CODE) { \
-  assert_false(strcmp(X, Y), MSG, CODE) \
+static inline void dare_context_push_int(char const *label, int64_t value) {
+  unsigned depth = dare_context.depth++;
+  if (depth < DARE_CONTEXT_MAX)
+    dare_context.entries[depth] = (struct dare_context_entry) { label, NULL, value };
+}
+
+//! Pop the last value pushed onto the context of the calling thread, if any.
+static inline void dare_context_pop(void) {
+  if (dare_context.depth) dare_context.depth--;
+}
+
+static inline void dare_context_leave(unsigned *depth) {
+  dare_context.depth = *depth;
 }
 
+#define dare_cat(A, B) dare_cat_(A, B)
+#define dare_cat_(A, B) A##B
+
 /*!
- * This macro throws an Exception with message and class code if its string
- * arguments are equal.
+ * This macro pushes a string onto the context until the end of the enclosing
+ * block.
+ *
+ * \example
+ * Exception serve(struct request *r) {
+ *     with_context("request", r->id);
+ *     ...
+ * }
+ */
+#define with_context(LABEL, STR) \
+  unsigned dare_cat(dare_context_, __COUNTER__) \
+    __attribute__((cleanup(dare_context_leave))) = dare_context.depth; \
+  dare_context_push_str(LABEL, STR)
+
+/*!
+ * This macro pushes an integer onto the context until the end of the
+ * enclosing block, like with_context().
+ */
+#define with_context_int(LABEL, VALUE) \
+  unsigned dare_cat(dare_context_, __COUNTER__) \
+    __attribute__((cleanup(dare_context_leave))) = dare_context.depth; \
+  dare_context_push_int(LABEL, VALUE)
+
+/*!
+ * Count the context entries copied into an Exception when it was created.
+ *
+ * \param e The Exception whose context entries are counted.
+ * \return  The number of entries, 0 if e is NULL.
+ */
+int dare_context_count(Exception e);
+
+/*!
+ * Get a context entry copied into an Exception, the outermost first.
+ *
+ * \param e     The Exception whose context is read.
+ * \param index The position of the entry, from 0 to dare_context_count() - 1.
+ * \return      The entry or NULL if there is none.
+ */
+struct dare_context_entry const *dare_context_at(Exception e, int index);
+
+// Some auxiliary macros
+#define xstr(X) str(X)
+#define str(X) #X
+#define dare_noop ((void)0)
+
+/*
+ * Branch hints and the attribute used for the out-of-line failure helpers.
+ *
+ * Cold functions are moved by GCC and Clang into `.text.unlikely`; on ELF
+ * targets the section is also requested explicitly so the helpers never share
+ * cache lines with the code that calls them.
+ */
+#if defined(__GNUC__)
+#define dare_likely(X) __builtin_expect(!!(X), 1)
+#define dare_unlikely(X) __builtin_expect(!!(X), 0)
+#if defined(__ELF__)
+#define DARE_COLD __attribute__((cold, noinline, section(".text.unlikely")))
+#else
+#define DARE_COLD __attribute__((cold, noinline))
+#endif
+#else
+#define dare_likely(X) (X)
+#define dare_unlikely(X) (X)
+#define DARE_COLD
+#endif
+
+//! The stacktrace line describing the place where the macro is expanded.
+#define DARE_LINE "  at " __FILE__ ":" xstr(__LINE__)
+
+/*!
+ * Create a new Exception and add the line where it was thrown.
+ *
+ * This is the out-of-line failure path of throw() and the assertions, do not
+ * call it directly.
+ */
+Exception dare_throw(char const *msg, int code, char const *line) DARE_COLD;
+
+/*!
+ * Add the line where an Exception was propagated.
+ *
+ * This is the out-of-line failure path of check(), do not call it directly.
+ */
+Exception dare_rethrow(Exception e, char const *line) DARE_COLD;
+
+/*!
+ * Wrap an Exception into a new one and add the line where it was wrapped.
+ *
+ * This is the out-of-line failure path of check_cause(), do not call it
+ * directly.
+ */
+Exception dare_throw_cause(Exception cause, char const *msg, int code,
+                           char const *line) DARE_COLD;
+
+/*!
+ * Create a new Exception with a formatted message and add the line where it
+ * was thrown.
+ *
+ * This is the out-of-line failure path of throwf(), do not call it directly.
+ */
+Exception dare_throwf(char const *line, int code, char const *fmt, ...)
+  DARE_COLD __attribute__((format(printf, 3, 4)));
+
+/*!
+ * Wrap an Exception into a new one with a formatted message and add the line
+ * where it was wrapped.
+ *
+ * This is the out-of-line failure path of check_causef(), do not call it
+ * directly.
  */
-#define assert_str_not_equal(X, Y, MSG, CODE) { \
-  assert_true(strcmp(X, Y), MSG, CODE) \
+Exception dare_throw_causef(Exception cause, char const *line, int code,
+                            char const *fmt, ...)
+  DARE_COLD __attribute__((format(printf, 4, 5)));
+
+/*
+ * Lazily formatted messages.
+ *
+ * The arguments of throwf_lazy() are captured with their types, so only the
+ * values are copied when throwing and the message is rendered the first time
+ * it is read.
+ */
+
+//! The maximum number of arguments of a lazily formatted message.
+#define DARE_LAZY_ARGS 5
+
+enum dare_arg_kind {
+  DARE_ARG_INT,
+  DARE_ARG_UINT,
+  DARE_ARG_DOUBLE,
+  DARE_ARG_PTR,
+  DARE_ARG_STR,
+};
+
+union dare_value {
+  long long i;
+  unsigned long long u;
+  double d;
+  void const *p;
+};
+
+struct dare_arg {
+  enum dare_arg_kind kind;
+  union dare_value value;
+};
+
+static inline struct dare_arg dare_arg_int(long long i) {
+  return (struct dare_arg) { DARE_ARG_INT, { .i = i } };
+}
+
+static inline struct dare_arg dare_arg_uint(unsigned long long u) {
+  return (struct dare_arg) { DARE_ARG_UINT, { .u = u } };
+}
+
+static inline struct dare_arg dare_arg_double(double d) {
+  return (struct dare_arg) { DARE_ARG_DOUBLE, { .d = d } };
+}
+
+static inline struct dare_arg dare_arg_ptr(void const *p) {
+  return (struct dare_arg) { DARE_ARG_PTR, { .p = p } };
+}
+
+static inline struct dare_arg dare_arg_str(char const *p) {
+  return (struct dare_arg) { DARE_ARG_STR, { .p = p } };
+}
+
+#define dare_arg(X) _Generic((X), \
+    _Bool: dare_arg_int, \
+    char: dare_arg_int, \
+    signed char: dare_arg_int, \
+    short: dare_arg_int, \
+    int: dare_arg_int, \
+    long: dare_arg_int, \
+    long long: dare_arg_int, \
+    unsigned char: dare_arg_uint, \
+    unsigned short: dare_arg_uint, \
+    unsigned: dare_arg_uint, \
+    unsigned long: dare_arg_uint, \
+    unsigned long long: dare_arg_uint, \
+    float: dare_arg_double, \
+    double: dare_arg_double, \
+    long double: dare_arg_double, \
+    char *: dare_arg_str, \
+    char const *: dare_arg_str, \
+    default: dare_arg_ptr)(X)
+
+// Expand the format and arguments into the format, the count and the array
+// of captured arguments. More than DARE_LAZY_ARGS arguments do not compile.
+#define dare_nargs(...) dare_nargs_(__VA_ARGS__, X, 5, 4, 3, 2, 1, 0)
+#define dare_nargs_(F, A, B, C, D, E, G, N, ...) N
+#define dare_lazy_args(...) dare_lazy_args_(dare_nargs(__VA_ARGS__), __VA_ARGS__)
+#define dare_lazy_args_(N, ...) dare_lazy_args__(N, __VA_ARGS__)
+#define dare_lazy_args__(N, ...) dare_lazy_##N(__VA_ARGS__)
+#define dare_lazy_0(F) F, 0, NULL
+#define dare_lazy_1(F, A) F, 1, (struct dare_arg const []) { dare_arg(A) }
+#define dare_lazy_2(F, A, B) F, 2, \
+  (struct dare_arg const []) { dare_arg(A), dare_arg(B) }
+#define dare_lazy_3(F, A, B, C) F, 3, \
+  (struct dare_arg const []) { dare_arg(A), dare_arg(B), dare_arg(C) }
+#define dare_lazy_4(F, A, B, C, D) F, 4, \
+  (struct dare_arg const []) { \
+    dare_arg(A), dare_arg(B), dare_arg(C), dare_arg(D) }
+#define dare_lazy_5(F, A, B, C, D, E) F, 5, \
+  (struct dare_arg const []) { \
+    dare_arg(A), dare_arg(B), dare_arg(C), dare_arg(D), dare_arg(E) }
+
+// Let the compiler check the format against the arguments without calling.
+#define dare_check_format(...) ((void) sizeof(printf(__VA_ARGS__)))
+
+/*!
+ * Construct a new Exception whose message will be formatted like printf()
+ * only when it is first read.
+ *
+ * Try not to call this function directly, use the macros throwf_lazy() or
+ * check_causef_lazy() instead.
+ *
+ * \param code  An integer code representing the Exception class.
+ * \param cause Another optional Exception that caused this new Exception, or
+ * NULL, in case there is none.
+ * \param fmt   The format of the message, which must outlive the Exception.
+ * \param count The number of arguments, up to DARE_LAZY_ARGS.
+ * \param args  The captured arguments.
+ * \return      The new Exception created or NULL in case of error.
+ */
+Exception new_exception_lazy(int code, Exception cause, char const *fmt,
+                             int count, struct dare_arg const *args);
+
+/*!
+ * Create a new Exception with a lazily formatted message and add the line
+ * where it was thrown.
+ *
+ * This is the out-of-line failure path of throwf_lazy(), do not call it
+ * directly.
+ */
+Exception dare_throw_lazy(char const *line, int code, char const *fmt,
+                          int count, struct dare_arg const *args) DARE_COLD;
+
+/*!
+ * Wrap an Exception into a new one with a lazily formatted message and add
+ * the line where it was wrapped.
+ *
+ * This is the out-of-line failure path of check_causef_lazy(), do not call it
+ * directly.
+ */
+Exception dare_throw_cause_lazy(Exception cause, char const *line, int code,
+                                char const *fmt, int count,
+                                struct dare_arg const *args) DARE_COLD;
+
+/*!
+ * Create a new Exception for a system call that failed and add the line where
+ * it was thrown. Its message is the expression that failed followed by the
+ * text of strerror_r(), formatted only when first read.
+ *
+ * This is the out-of-line failure path of check_errno(), check_rc() and
+ * check_ptr(), do not call it directly.
+ */
+Exception dare_throw_errno(char const *expr, int error, char const *line)
+  DARE_COLD;
+
+/*!
+ * Extract the errno value from an Exception thrown by check_errno(),
+ * check_rc() or check_ptr().
+ *
+ * \param e The Exception whose errno value will be extracted.
+ * \return  The errno value or 0 if it has none.
+ */
+int get_errno(Exception e);
+
+/*
+ * Serialization.
+ *
+ * A chain is encoded in a compact binary format, with varints for numbers, to
+ * be sent through a pipe or a queue: the codes, errno values, messages,
+ * details, fields and lines of all its Exceptions, but not the children of
+ * aggregates nor the thread context. The bytes received can be read in place
+ * through a view, without allocating, or turned back into an Exception.
+ */
+
+//! A validated buffer of serialized Exceptions, read one record at a time.
+struct dare_view {
+  unsigned char const *next;  //< where the next record starts
+  unsigned char const *end;   //< where the last record ends
+  uint64_t remaining;         //< how many records are left
+};
+
+//! One serialized Exception, whose strings point into the buffer.
+struct dare_record {
+  int code;
+  int error;                    //< the errno value, see get_errno()
+  int transient;
+  int64_t retry_after;
+  uint64_t fingerprint;
+  char const *msg;
+  char const *detail;           //< NULL if it has none
+  int field_count;
+  int line_count;
+  unsigned char const *fields;  //< read with dare_record_field()
+  unsigned char const *lines;   //< read with dare_record_line()
+  unsigned char const *end;
+};
+
+/*!
+ * Encode an Exception and its causes into a buffer.
+ *
+ * Like snprintf(), it returns the size needed, and the buffer holds a valid
+ * encoding only if that is not larger than its size.
+ *
+ * \param e    The Exception to be encoded.
+ * \param buf  The buffer, which may be NULL to get the size needed.
+ * \param size The size of the buffer.
+ * \return     The size of the encoding or 0 if e is NULL.
+ */
+size_t dare_serialize(Exception e, void *buf, size_t size);
+
+/*!
+ * Decode a chain of Exceptions, allocated in a single block that cancel()
+ * frees with the outermost one, like compact() does.
+ *
+ * \param buf  The bytes made by dare_serialize().
+ * \param size How many bytes there are.
+ * \return     The outermost Exception or NULL if the bytes are malformed or
+ *             the memory is exhausted.
+ */
+Exception dare_deserialize(void const *buf, size_t size);
+
+/*!
+ * Open a view over serialized Exceptions, validating all the bytes once so
+ * that reading them later needs no more checks.
+ *
+ * \param v    The view to be opened.
+ * \param buf  The bytes made by dare_serialize(), which must outlive the view.
+ * \param size How many bytes there are.
+ * \return     0 on success or -1 if the bytes are malformed.
+ */
+int dare_view_open(struct dare_view *v, void const *buf, size_t size);
+
+/*!
+ * Read the next record of a view, from the outermost Exception to its root
+ * cause.
+ *
+ * \param v   The view.
+ * \param rec Where the record is read to.
+ * \return    1 if a record was read, 0 if there are no more.
+ */
+int dare_view_next(struct dare_view *v, struct dare_record *rec);
+
+/*!
+ * Read a field of a record. String values point into the buffer.
+ *
+ * \param rec   The record.
+ * \param index The index of the field, from 0 to its field_count - 1.
+ * \param key   Where its key is stored, if not NULL.
+ * \param value Where its value is stored, if not NULL.
+ * \return      Its kind, an enum dare_field_kind, or -1 if out of range.
+ */
+int dare_record_field(struct dare_record const *rec, int index,
+                      char const **key, union dare_value *value);
+
+/*!
+ * Read a line of a record, in the order they were added.
+ *
+ * \param rec   The record.
+ * \param index The index of the line, from 0 to its line_count - 1.
+ * \return      The line, pointing into the buffer, or NULL if out of range.
+ */
+char const *dare_record_line(struct dare_record const *rec, int index);
+
+//! Success is indicated by returning a NULL pointer, i.e. no Exception.
+#define SUCCESS NULL
+
+//! The code of the Exceptions thrown by the library itself, all below it.
+#define DARE_EXCEPTION -1000
+#define DARE_DEFER_EXCEPTION -1001
+#define DARE_DEFER_OVERFLOW "Too many deferred actions"
+#define DARE_AGGREGATE_EXCEPTION -1002
+#define DARE_AGGREGATE_MSG "Some operations failed"
+#define DARE_ERRNO_EXCEPTION -1003
+#define DARE_TIMEOUT_EXCEPTION -1004
+#define DARE_TIMEOUT_MSG "Deadline exceeded"
+#define DARE_CIRCUIT_OPEN_EXCEPTION -1005
+#define DARE_CIRCUIT_OPEN_MSG "Circuit open"
+//! This is the name of the Exception variable, redefine at will.
+#define EVAR dare_exception
+
+/*!
+ * This macro defines a try clause that receives a BLOCK of code.
+ *
+ * It opens a region with its own failure label, declared with `__label__`,
+ * and its own variable for the Exception being thrown. The macros that throw
+ * refer to the innermost region around them, so any number of try clauses may
+ * follow each other or be nested in the same function, even inside loops. A
+ * throw inside a catch block goes to the region around the try-catch.
+ *
+ * The variables declared in the BLOCK are local to it.
+ *
+ * \example
+ * try (
+ *     // some code here that may throw Exceptions
+ * ) catch (
+ *     // some code here that deals with the Exception at EVAR
+ * )
+ */
+#define try(...) { \
+  __label__ dare_success; \
+  Exception dare_caught; \
+  { \
+    __label__ dare_failure; \
+    Exception dare_thrown; \
+    __VA_ARGS__ \
+    goto dare_success; \
+  dare_failure: \
+    dare_caught = dare_thrown; \
+  }
+
+/*!
+ * This macro defines a check clause that receives a call to a function that may
+ * throw, i.e. return an Exception.
+ *
+ * This macro should be used only inside a try block and only around functions
+ * that may return Exceptions.
+ *
+ * \example
+ * try (
+ *     // suppose division throws if b is zero
+ *     check(division(a,b))
+ * ) catch (
+ *     // deal with the Exception at EVAR
+ * )
+ */
+#define check(EXPR) { \
+  dare_thrown = EXPR; \
+  if (dare_unlikely(dare_thrown != SUCCESS)) { \
+    dare_thrown = dare_rethrow(dare_thrown, DARE_LINE); \
+    goto dare_failure; \
+  } \
+}
+
+/*!
+ * This macro defines a check clause that checks for an Exception, and throws
+ * another one with the first one as its cause.
+ *
+ * This macro should be used only inside a try block and only around functions
+ * that may return Exceptions.
+ *
+ * \example
+ * try (
+ *     // suppose division throws if b is zero
+ *     check_cause(division(a,b), INVALID_OP, "Uh-oh!")
+ * ) catch (
+ *     // if division throws EVAR has an Exception with cause here
+ * )
+ */
+#define check_cause(EXPR, MSG, CODE) { \
+  dare_thrown = EXPR; \
+  if (dare_unlikely(dare_thrown != SUCCESS)) { \
+    dare_thrown = dare_throw_cause(dare_thrown, MSG, CODE, DARE_LINE); \
+    goto dare_failure; \
+  } \
+}
+
+/*!
+ * This macro defines a catch clause to deal with a possible Exception thrown
+ * from the try block before.
+ *
+ * It must immediately follow the end of the try block, and it closes the
+ * region opened by it. EVAR is local to the catch block.
+ *
+ * \example
+ * try (
+ *     // suppose a Exception maybe thrown here
+ * ) catch (
+ *     // it will be accessible here in EVAR
+ *     print_stacktrace(EVAR);
+ * )
+ */
+#define catch(...) \
+  { \
+    Exception EVAR = dare_caught; \
+    __VA_ARGS__ \
+  } \
+dare_success: \
+  dare_noop; \
+}
+
+/*!
+ * This macro throws a new Exception with a message and a class code.
+ *
+ * This macro must be used only inside a try block. If the exception is to be
+ * rethrown by the surrounding function, it must be returned from the catch
+ * block.
+ *
+ * \example
+ * try (
+ *     // throw the Exception here
+ *     if (answer != 42) throw("Something is wrong", 42)
+ * ) catch (
+ *     // catch and rethrow it here
+ *     return EVAR;
+ * )
+ */
+#define throw(MSG, CODE) { \
+  dare_thrown = dare_throw(MSG, CODE, DARE_LINE); \
+  goto dare_failure; \
+}
+
+/*!
+ * This macro throws a new Exception with a class code and a message formatted
+ * like printf(), which may include the values involved in the failure.
+ *
+ * \example
+ * try (
+ *     if (fd < 0) throwf(IO_EXCEPTION, "Cannot open %s (fd %d)", path, fd)
+ * ) catch (
+ *     return EVAR;
+ * )
+ */
+#define throwf(CODE, ...) { \
+  dare_thrown = dare_throwf(DARE_LINE, CODE, __VA_ARGS__); \
+  goto dare_failure; \
+}
+
+/*!
+ * This macro works like check_cause(), but the message of the new Exception
+ * is formatted like printf().
+ */
+#define check_causef(EXPR, CODE, ...) { \
+  dare_thrown = EXPR; \
+  if (dare_unlikely(dare_thrown != SUCCESS)) { \
+    dare_thrown = dare_throw_causef(dare_thrown, DARE_LINE, CODE, __VA_ARGS__); \
+    goto dare_failure; \
+  } \
+}
+
+/*!
+ * This macro works like throwf(), but only captures the arguments and
+ * formats the message when it is first read by get_msg() or
+ * fprint_stacktrace(), since most Exceptions are cancelled unread.
+ *
+ * At most DARE_LAZY_ARGS arguments are accepted, and strings passed to %s
+ * must live at least as long as the Exception.
+ */
+#define throwf_lazy(CODE, ...) { \
+  dare_check_format(__VA_ARGS__); \
+  dare_thrown = dare_throw_lazy(DARE_LINE, CODE, dare_lazy_args(__VA_ARGS__)); \
+  goto dare_failure; \
+}
+
+/*!
+ * This macro works like check_causef(), but the message is formatted lazily
+ * like in throwf_lazy().
+ */
+#define check_causef_lazy(EXPR, CODE, ...) { \
+  dare_thrown = EXPR; \
+  if (dare_unlikely(dare_thrown != SUCCESS)) { \
+    dare_check_format(__VA_ARGS__); \
+    dare_thrown = dare_throw_cause_lazy(dare_thrown, DARE_LINE, CODE, \
+                                        dare_lazy_args(__VA_ARGS__)); \
+    goto dare_failure; \
+  } \
+}
+
+/*!
+ * Add an Exception to an aggregate, creating it if needed, and record the
+ * index of the operation that failed in its field "index".
+ *
+ * This is the out-of-line failure path of check_all(), do not call it
+ * directly.
+ *
+ * \return The aggregate.
+ */
+Exception dare_collect(Exception all, Exception e, size_t index) DARE_COLD;
+
+/*!
+ * This macro evaluates an expression for each I from 0 to N - 1 and, if any
+ * of them returns an Exception, throws an aggregate Exception holding all of
+ * them, in order, after the last one.
+ *
+ * The aggregate has the code DARE_AGGREGATE_EXCEPTION and each child records
+ * the I it failed for in its field "index".
+ *
+ * \example
+ * try (
+ *     check_all(count, i, validate(&records[i]))
+ * ) catch (
+ *     for (size_t i = 0; i < get_child_count(EVAR); i++)
+ *         report(get_child(EVAR, i));
+ *     cancel(EVAR);
+ * )
+ */
+#define check_all(N, I, EXPR) { \
+  Exception dare_all = SUCCESS; \
+  size_t dare_count = (N); \
+  for (size_t I = 0; I < dare_count; I++) { \
+    Exception dare_one = (EXPR); \
+    if (dare_unlikely(dare_one != SUCCESS)) \
+      dare_all = dare_collect(dare_all, dare_one, I); \
+  } \
+  if (dare_unlikely(dare_all != SUCCESS)) { \
+    dare_thrown = dare_rethrow(dare_all, DARE_LINE); \
+    goto dare_failure; \
+  } \
+}
+
+/*!
+ * This macro throws an Exception if a call following the POSIX convention
+ * returns -1, with the code DARE_ERRNO_EXCEPTION and the value of errno.
+ *
+ * The success path is a single comparison, so system calls need not be
+ * wrapped into functions returning Exceptions. The result can be kept by
+ * assigning it inside the expression.
+ *
+ * \example
+ * try (
+ *     check_errno(fd = open(path, O_RDONLY))
+ *     check_errno(fstat(fd, &st))
+ * ) catch (
+ *     if (get_errno(EVAR) == ENOENT) ...
+ * )
+ */
+#define check_errno(EXPR) { \
+  if (dare_unlikely((EXPR) == -1)) { \
+    dare_thrown = dare_throw_errno(#EXPR, errno, DARE_LINE); \
+    goto dare_failure; \
+  } \
+}
+
+/*!
+ * This macro throws an Exception if a call returns a negative value, taking
+ * its negation as the errno value, like the Linux system calls and io_uring
+ * report errors.
+ */
+#define check_rc(EXPR) { \
+  __auto_type dare_rc = (EXPR); \
+  if (dare_unlikely(dare_rc < 0)) { \
+    dare_thrown = dare_throw_errno(#EXPR, (int) -dare_rc, DARE_LINE); \
+    goto dare_failure; \
+  } \
+}
+
+/*!
+ * This macro throws an Exception with the value of errno if a call returns
+ * NULL, like malloc() or fopen().
+ */
+#define check_ptr(EXPR) { \
+  if (dare_unlikely((EXPR) == NULL)) { \
+    dare_thrown = dare_throw_errno(#EXPR, errno, DARE_LINE); \
+    goto dare_failure; \
+  } \
+}
+
+/*
+ * Deferred actions.
+ *
+ * A try_defer block has a small stack of cleanup actions living in its own
+ * stack frame, so registering one never allocates. The stack is run in reverse
+ * order when the block is left, whether it finished, returned or threw, before
+ * the catch block runs.
+ *
+ * Plain try blocks have no such stack: a variable with a cleanup attribute
+ * keeps the compiler from seeing that a function whose try and catch blocks
+ * both return never reaches its end.
+ */
+#ifndef DARE_DEFER_MAX
+#define DARE_DEFER_MAX 8
+#endif
+
+//! An action deferred in a try block.
+struct dare_defer {
+  void (*fn)(void *);
+  void *arg;
+};
+
+/*
+ * The stack of actions deferred in a try block. The slots are a separate
+ * array so the compiler drops both when nothing is deferred.
+ */
+struct dare_defers {
+  unsigned count;
+  struct dare_defer *slots;
+};
+
+static inline __attribute__((always_inline))
+void dare_defers_run(struct dare_defers *d) {
+  while (d->count) {
+    d->count--;
+    d->slots[d->count].fn(d->slots[d->count].arg);
+  }
+}
+
+/*!
+ * This macro defines a try clause like try() whose BLOCK may register actions
+ * with defer(), run when it is left. It is followed by a catch clause too.
+ */
+#define try_defer(...) try ( \
+  struct dare_defer dare_defer_slots[DARE_DEFER_MAX]; \
+  struct dare_defers dare_defers __attribute__((cleanup(dare_defers_run))) \
+    = { 0, dare_defer_slots }; \
+  __VA_ARGS__ \
+)
+
+/*!
+ * This macro registers FN(ARG) to be called when the innermost try_defer
+ * block around it is left.
+ *
+ * If DARE_DEFER_MAX actions are already registered FN(ARG) is called at once
+ * and an Exception is thrown.
+ *
+ * \example
+ * try_defer (
+ *     char *scratch = malloc(SCRATCH_SIZE);
+ *     assert_not_null(scratch, OUT_OF_MEMORY, MAIN_EXCEPTION);
+ *     defer(free, scratch);
+ *     check(fill(scratch)) // scratch is freed even if fill() throws
+ *     return SUCCESS;
+ * ) catch (
+ *     return EVAR;
+ * )
+ */
+#define defer(FN, ARG) { \
+  if (dare_unlikely(dare_defers.count == DARE_DEFER_MAX)) { \
+    (FN)(ARG); \
+    throw(DARE_DEFER_OVERFLOW, DARE_DEFER_EXCEPTION) \
+  } \
+  dare_defers.slots[dare_defers.count].fn = (FN); \
+  dare_defers.slots[dare_defers.count].arg = (ARG); \
+  dare_defers.count++; \
+}
+
+/*
+ * Exception classes.
+ *
+ * A class is an interval of codes and its subclasses are intervals nested in
+ * it, so whether an Exception belongs to a class, or any of its subclasses,
+ * is a single unsigned compare and catch_class() clauses are switch cases the
+ * compiler can turn into a jump table. Classes are constants and the optional
+ * descriptors made by DARE_CLASS_INFO() are static data gathered by the
+ * linker, so there is nothing to register at runtime.
+ */
+
+/*!
+ * Declare a class with the codes from FIRST to LAST, usually in a header.
+ *
+ * \example
+ * DARE_CLASS(IO_ERROR, 1000, 1999);
+ */
+#define DARE_CLASS(NAME, FIRST, LAST) \
+  enum { NAME##_FIRST = (FIRST), NAME##_LAST = (LAST) }; \
+  _Static_assert((FIRST) <= (LAST), #NAME " has no codes")
+
+/*!
+ * Declare a subclass of PARENT with the codes from FIRST to LAST, which must
+ * be inside the codes of PARENT.
+ *
+ * \example
+ * DARE_SUBCLASS(DISK_ERROR, IO_ERROR, 1100, 1199);
+ */
+#define DARE_SUBCLASS(NAME, PARENT, FIRST, LAST) \
+  DARE_CLASS(NAME, FIRST, LAST); \
+  _Static_assert(PARENT##_FIRST <= (FIRST) && (LAST) <= PARENT##_LAST, \
+                 #NAME " is not inside " #PARENT)
+
+//! A class described at runtime, to find the class of a code by its name.
+struct dare_class {
+  char const *name;
+  int first;
+  int last;
+};
+
+/*!
+ * Describe a declared class to get_class() and dare_class_parent(). Use it in
+ * only one source file for each class.
+ */
+#if defined(__GNUC__) && defined(__ELF__)
+#define DARE_HAVE_CLASSES 1
+#define DARE_CLASS_INFO(NAME) \
+  struct dare_class const dare_class_##NAME \
+    __attribute__((section("dare_classes"), used, aligned(8))) = \
+    { #NAME, NAME##_FIRST, NAME##_LAST }
+#else
+#define DARE_CLASS_INFO(NAME) \
+  struct dare_class const dare_class_##NAME = \
+    { #NAME, NAME##_FIRST, NAME##_LAST }
+#endif
+
+static inline int dare_in_class(int code, int first, int last) {
+  return (unsigned) code - (unsigned) first <= (unsigned) last - (unsigned) first;
+}
+
+/*!
+ * This macro tells whether an Exception belongs to a class or to any of its
+ * subclasses.
+ */
+#define is_a(E, CLASS) \
+  dare_is_a((E), CLASS##_FIRST, CLASS##_LAST)
+
+static inline int dare_is_a(Exception e, int first, int last) {
+  return e && dare_in_class(get_code(e), first, last);
+}
+
+/*!
+ * Find the innermost described class of an Exception.
+ *
+ * \param e The Exception whose class is searched.
+ * \return  The class or NULL if no class described by DARE_CLASS_INFO()
+ * contains its code.
+ */
+struct dare_class const *get_class(Exception e);
+
+/*!
+ * Find the innermost described class that contains another one.
+ *
+ * \param c The class whose parent is searched.
+ * \return  The parent class or NULL if there is none.
+ */
+struct dare_class const *dare_class_parent(struct dare_class const *c);
+
+/*!
+ * This macro dispatches the caught Exception to the catch_class() and
+ * catch_other() clauses inside it, by its code.
+ *
+ * The classes of its clauses must not overlap, which is checked when
+ * compiling; to handle a subclass apart, nest another catch_classes() in the
+ * clause of its parent. A break inside a clause leaves the dispatch.
+ *
+ * \example
+ * try (
+ *     check(run(engine))
+ * ) catch (
+ *     catch_classes (
+ *         catch_class(STACK_ERROR, puts("The stack is full");)
+ *         catch_class(ENGINE_ERROR, print_stacktrace(EVAR);)
+ *         catch_other(return EVAR;)
+ *     )
+ *     cancel(EVAR);
+ * )
+ */
+#define catch_classes(...) \
+  switch (get_code(EVAR)) { \
+    __VA_ARGS__ \
+  }
+
+/*!
+ * This macro defines a clause of catch_classes() run when the caught
+ * Exception belongs to CLASS or to any of its subclasses.
+ */
+#define catch_class(CLASS, ...) \
+  case CLASS##_FIRST ... CLASS##_LAST: { \
+    __VA_ARGS__ \
+  } \
+  break;
+
+/*!
+ * This macro defines the clause of catch_classes() run when the caught
+ * Exception belongs to none of the classes of the other clauses.
+ */
+#define catch_other(...) \
+  default: { \
+    __VA_ARGS__ \
+  } \
+  break;
+
+/*
+ * Retries.
+ *
+ * An Exception can be marked as transient, i.e. likely to go away if the
+ * failed operation is tried again, optionally with the time to wait before
+ * that. check_retry() evaluates an expression again while it fails with
+ * transient Exceptions, waiting an exponential backoff with jitter between
+ * the attempts.
+ */
+
+/*!
+ * Mark an Exception as transient.
+ *
+ * \param e              The Exception to be marked.
+ * \param retry_after_ns The minimum time to wait before trying again, in
+ * nanoseconds, or 0 to wait only as long as the retry policy says.
+ * \return               The Exception marked.
+ */
+Exception set_transient(Exception e, int64_t retry_after_ns);
+
+/*!
+ * Tell whether an Exception is transient.
+ *
+ * \return 1 if it was marked as transient, 0 otherwise or if e is NULL.
+ */
+int is_transient(Exception e);
+
+/*!
+ * Return the minimum time to wait before trying again after an Exception.
+ *
+ * \return The time in nanoseconds, 0 if there is none or if e is NULL.
+ */
+int64_t get_retry_after(Exception e);
+
+/*!
+ * Return how many times check_retry() evaluated the expression that failed
+ * with an Exception.
+ *
+ * \return The number of attempts, 0 if the Exception did not come from
+ * check_retry() or if e is NULL.
+ */
+int get_attempts(Exception e);
+
+//! How many times to try and how long to wait in between.
+struct dare_retry_policy {
+  int max_attempts;
+  int64_t base_ns;
+  int64_t max_ns;
+};
+
+/*!
+ * A retry policy making at most ATTEMPTS attempts and waiting BASE_NS
+ * nanoseconds after the first one, doubling the wait after each other attempt
+ * up to MAX_NS. Each wait is drawn between its half and its whole.
+ */
+#define DARE_RETRY(ATTEMPTS, BASE_NS, MAX_NS) \
+  ((struct dare_retry_policy) { (ATTEMPTS), (BASE_NS), (MAX_NS) })
+
+struct dare_retry {
+  struct dare_retry_policy const *policy;
+  int attempt;
+  int64_t deadline;
+};
+
+/*!
+ * Decide whether to try again after an attempt failed with an Exception and,
+ * if so, cancel it and wait until the next attempt.
+ *
+ * This is the out-of-line failure path of check_retry(), do not call it
+ * directly.
+ *
+ * \return 1 to try again, 0 to throw the Exception.
+ */
+int dare_retry_again(struct dare_retry *retry, Exception e) DARE_COLD;
+
+/*!
+ * This macro works like check(), but evaluates its expression again while it
+ * returns transient Exceptions, following a retry policy. The last Exception
+ * is thrown with the number of attempts made, the others are cancelled.
+ *
+ * The waits are measured against absolute deadlines from the first failure,
+ * so the time spent in the expression itself does not make them drift.
+ *
+ * \example
+ * try (
+ *     check_retry(send(socket, message), DARE_RETRY(5, 1000000, 100000000))
+ * ) catch (
+ *     return EVAR;
+ * )
+ */
+#define check_retry(EXPR, POLICY) { \
+  struct dare_retry dare_retry = { &(POLICY), 0, 0 }; \
+  while (dare_unlikely((dare_thrown = (EXPR)) != SUCCESS) \
+         && dare_retry_again(&dare_retry, dare_thrown)) \
+    continue; \
+  if (dare_unlikely(dare_thrown != SUCCESS)) { \
+    dare_thrown = dare_rethrow(dare_thrown, DARE_LINE); \
+    goto dare_failure; \
+  } \
+}
+
+/*!
+ * This macro throws a new transient Exception, which check_retry() will try
+ * to avoid by trying again after at least RETRY_AFTER_NS nanoseconds.
+ */
+#define throw_transient(MSG, CODE, RETRY_AFTER_NS) { \
+  dare_thrown = set_transient(dare_throw(MSG, CODE, DARE_LINE), RETRY_AFTER_NS); \
+  goto dare_failure; \
+}
+
+/*
+ * Deadlines.
+ *
+ * Each thread has a deadline, none by default, set for the rest of a block by
+ * with_deadline(). Without one, checking it is a load and a compare. With
+ * one, it also reads CLOCK_MONOTONIC_COARSE, the time of the last tick cached
+ * by the kernel in the vDSO, which costs no system call and is precise to a
+ * few milliseconds.
+ */
+
+//! The deadline of a thread, all in nanoseconds of the monotonic clock.
+struct dare_deadline {
+  int64_t at;      //< when it expires, INT64_MAX if never
+  int64_t start;   //< when it was set
+  int64_t budget;  //< how long it was given
+};
+
+//! The deadline of the calling thread.
+extern _Thread_local struct dare_deadline dare_deadline;
+
+//! Read the coarse clock deadlines are checked against, in nanoseconds.
+int64_t dare_deadline_now(void);
+
+/*!
+ * Set the deadline of the calling thread to budget_ns from now, unless the one
+ * it has is sooner.
+ *
+ * \param budget_ns How long from now, in nanoseconds.
+ * \return          The deadline it had, to be restored by dare_deadline_leave().
+ */
+struct dare_deadline dare_deadline_enter(int64_t budget_ns);
+
+static inline void dare_deadline_leave(struct dare_deadline *saved) {
+  dare_deadline = *saved;
+}
+
+/*!
+ * Get how long is left until the deadline of the calling thread, to pass it
+ * on to calls that wait.
+ *
+ * \return The nanoseconds left, 0 if it expired or INT64_MAX if it has none.
+ */
+int64_t dare_deadline_left(void);
+
+/*!
+ * Create a new Exception for the deadline of the calling thread that expired
+ * and add the line where it was thrown.
+ *
+ * This is the out-of-line failure path of check_deadline(), do not call it
+ * directly.
+ */
+Exception dare_throw_timeout(char const *line) DARE_COLD;
+
+/*!
+ * This macro sets the deadline of the calling thread to BUDGET_NS nanoseconds
+ * from now until the end of the enclosing block, where the one it had before
+ * is restored. A deadline set inside another never extends it.
+ *
+ * \example
+ * Exception serve(struct request *r) {
+ *     with_deadline(50 * 1000000);
+ *     ...
+ * }
+ */
+#define with_deadline(BUDGET_NS) \
+  struct dare_deadline dare_cat(dare_deadline_, __COUNTER__) \
+    __attribute__((cleanup(dare_deadline_leave))) \
+    = dare_deadline_enter(BUDGET_NS)
+
+/*!
+ * This macro throws an Exception with the code DARE_TIMEOUT_EXCEPTION if the
+ * deadline of the calling thread has expired, with the nanoseconds elapsed
+ * since it was set and its budget in the fields "elapsed" and "budget".
+ */
+#define check_deadline() { \
+  if (dare_deadline.at != INT64_MAX \
+      && dare_unlikely(dare_deadline_now() >= dare_deadline.at)) { \
+    dare_thrown = dare_throw_timeout(DARE_LINE); \
+    goto dare_failure; \
+  } \
+}
+
+/*
+ * Assertion levels.
+ *
+ * Every assertion is tagged with a level. Those tagged above DARE_ASSERT_LEVEL
+ * compile to a constant false condition, i.e. to nothing, and their operands
+ * are never evaluated. The plain assertions are tagged DARE_ASSERT_NORMAL, the
+ * variants with the suffix `_at` receive the level as their first argument.
+ *
+ * The level is read where each assertion is expanded, so it may be set for a
+ * whole translation unit defining it before including this header, or changed
+ * for a part of it with `#undef` and `#define`:
+ *
+ * \example
+ * #define DARE_ASSERT_LEVEL DARE_ASSERT_PARANOID
+ * #include "dare.h"
+ * // all assertions are checked here, at the module boundaries
+ * #undef DARE_ASSERT_LEVEL
+ * #define DARE_ASSERT_LEVEL DARE_ASSERT_CRITICAL
+ * // only critical assertions are checked here, inside the kernels
+ */
+#define DARE_ASSERT_NONE 0      //< no assertion is checked
+#define DARE_ASSERT_CRITICAL 1  //< assertions that must never be stripped
+#define DARE_ASSERT_NORMAL 2    //< the default level of the assertions
+#define DARE_ASSERT_PARANOID 3  //< expensive assertions, usually for debugging
+
+#ifndef DARE_ASSERT_LEVEL
+#define DARE_ASSERT_LEVEL DARE_ASSERT_NORMAL
+#endif
+
+//! Whether the assertions tagged with LEVEL are compiled at this point.
+#define dare_assert_enabled(LEVEL) ((LEVEL) <= DARE_ASSERT_LEVEL)
+
+/*
+ * Assertion sites.
+ *
+ * Each compiled assertion owns a descriptor with a one byte enable flag, kept
+ * in the section `dare_sites` so the whole set can be listed and toggled at
+ * runtime with dare_sites_set(), dare_sites_control() or dare_sites_watch().
+ * Sites tagged above DARE_ASSERT_ACTIVE_LEVEL start disabled, so expensive
+ * assertions can be compiled in and switched on only when needed.
+ *
+ * The flag is tested, as a predicted-taken branch, before the condition is
+ * evaluated for paranoid assertions, whose condition is considered expensive,
+ * for the sites that start disabled and for the array assertions. For the
+ * other sites the condition is evaluated first and the flag is only read once
+ * it fails, so the success path costs nothing extra.
+ *
+ * Only the sites linked in the same module (executable or shared library) as
+ * dare_sites.c are visible. Without GCC or Clang on an ELF target every compiled
+ * assertion is always enabled and the functions below do nothing.
+ */
+#ifndef DARE_ASSERT_ACTIVE_LEVEL
+#define DARE_ASSERT_ACTIVE_LEVEL DARE_ASSERT_LEVEL
+#endif
+
+//! The descriptor of an assertion site.
+struct dare_site {
+  volatile unsigned char enabled; //< checked before evaluating the assertion
+  unsigned char compiled;         //< zero if stripped by DARE_ASSERT_LEVEL
+  unsigned char level;            //< the level the assertion is tagged with
+  unsigned char has_code;         //< whether the code is a constant
+  int line;
+  int code;
+  char const *file;
+  char const *func;
+};
+
+//! What dare_sites_set() matches, zeroed fields match any site.
+struct dare_site_filter {
+  char const *file;   //< the file name or a suffix of it after a '/'
+  char const *func;   //< the function name
+  int first_line;     //< the first line of the range
+  int last_line;      //< the last line of the range
+  int level;          //< the level the assertions are tagged with
+  int match_code;     //< whether the code below must match
+  int code;           //< the code of the Exceptions thrown
+};
+
+#if defined(__GNUC__) && defined(__ELF__)
+#define DARE_HAVE_SITES 1
+#define dare_site_check(LEVEL, CODE, FLAG_FIRST, FAILED) __extension__ ({ \
+  static struct dare_site dare_site \
+    __attribute__((section("dare_sites"), used, aligned(8))) = { \
+    .enabled = dare_assert_enabled(LEVEL) \
+      && (LEVEL) <= DARE_ASSERT_ACTIVE_LEVEL, \
+    .compiled = dare_assert_enabled(LEVEL), \
+    .level = (LEVEL), \
+    .has_code = __builtin_constant_p(CODE), \
+    .line = __LINE__, \
+    .code = __builtin_constant_p(CODE) ? (CODE) : 0, \
+    .file = __FILE__, \
+    .func = __func__, \
+  }; \
+  (FLAG_FIRST) \
+    ? dare_likely(dare_site.enabled) && dare_unlikely(FAILED) \
+    : dare_unlikely(FAILED) && dare_site.enabled; \
+})
+#else
+#define dare_site_check(LEVEL, CODE, FLAG_FIRST, FAILED) \
+  ((LEVEL) <= DARE_ASSERT_ACTIVE_LEVEL && dare_unlikely(FAILED))
+#endif
+
+//! Whether FAILED holds and the site is enabled, tested in the order above.
+#define dare_site_failed(LEVEL, CODE, FAILED) \
+  dare_site_check(LEVEL, CODE, (LEVEL) >= DARE_ASSERT_PARANOID \
+                  || (LEVEL) > DARE_ASSERT_ACTIVE_LEVEL, FAILED)
+
+/*!
+ * Enable or disable the assertion sites matching a filter.
+ *
+ * Stripped sites are never enabled.
+ *
+ * \param filter  Which sites to change.
+ * \param enabled Non zero to enable the sites, zero to disable them.
+ * \return        How many sites matched.
+ */
+int dare_sites_set(struct dare_site_filter const *filter, int enabled);
+
+/*!
+ * Enable or disable the assertion sites matching a textual query.
+ *
+ * A query is made of pairs of keyword and value followed by a flag, `+` to
+ * enable or `-` to disable the matching sites. The keywords are `file`,
+ * `func`, `line` (a number or a range like `10-40`), `level` and `code`.
+ * Several queries may be separated by new lines or semicolons.
+ *
+ * This function is async-signal-safe.
+ *
+ * \example
+ * dare_sites_control("file stack.c func push -; level 3 +");
+ *
+ * \param query The queries to apply.
+ * \return      How many sites matched or -1 if a query is malformed.
+ */
+int dare_sites_control(char const *query);
+
+/*!
+ * Apply the queries found in a control file whenever a signal arrives.
+ *
+ * \example
+ * dare_sites_watch("/run/myapp/assertions", SIGUSR1);
+ * // later: echo 'file engine.c +' > /run/myapp/assertions; kill -USR1 <pid>
+ *
+ * \param path  The control file, read with dare_sites_control() syntax.
+ * \param signo The signal that triggers the reading.
+ * \return      Zero on success or -1 in case of error.
+ */
+int dare_sites_watch(char const *path, int signo);
+
+/*!
+ * List all the assertion sites and their state.
+ *
+ * \param fp The stream to which the list will be printed.
+ * \return   How many sites were listed.
+ */
+int dare_sites_fprint(FILE *fp);
+
+/*!
+ * This macro throws an Exception with message and class code if its argument
+ * is zero (not TRUE).
+ */
+#define assert_true(X, MSG, CODE) \
+  assert_true_at(DARE_ASSERT_NORMAL, X, MSG, CODE)
+#define assert_true_at(LEVEL, X, MSG, CODE) { \
+  if (dare_assert_enabled(LEVEL) && dare_site_failed(LEVEL, CODE, !(X))) \
+    throw(MSG, CODE) \
+}
+
+/*!
+ * This macro throws an Exception with message and class code if its argument
+ * is not zero (not FALSE).
+ */
+#define assert_false(X, MSG, CODE) \
+  assert_false_at(DARE_ASSERT_NORMAL, X, MSG, CODE)
+#define assert_false_at(LEVEL, X, MSG, CODE) { \
+  if (dare_assert_enabled(LEVEL) && dare_site_failed(LEVEL, CODE, X)) \
+    throw(MSG, CODE) \
+}
+
+/*!
+ * This macro throws an Exception with message and class code if its argument
+ * is not NULL.
+ */
+#define assert_null(X, MSG, CODE) \
+  assert_null_at(DARE_ASSERT_NORMAL, X, MSG, CODE)
+#define assert_null_at(LEVEL, X, MSG, CODE) { \
+  assert_true_at(LEVEL, (X) == NULL, MSG, CODE) \
+}
+
+/*!
+ * This macro throws an Exception with message and class code if its argument
+ * is NULL.
+ */
+#define assert_not_null(X, MSG, CODE) \
+  assert_not_null_at(DARE_ASSERT_NORMAL, X, MSG, CODE)
+#define assert_not_null_at(LEVEL, X, MSG, CODE) { \
+  assert_false_at(LEVEL, (X) == NULL, MSG, CODE) \
+}
+
+/*!
+ * Create a new Exception with a lazily formatted detail and add the line
+ * where it was thrown. Besides the conversions of printf(), the format of
+ * the detail accepts %v, which prints an argument as the type it was
+ * captured with.
+ *
+ * This is the out-of-line failure path of the comparison assertions, do not
+ * call it directly.
+ */
+Exception dare_throw_detail(char const *msg, int code, char const *line,
+                            char const *fmt, int count,
+                            struct dare_arg const *args) DARE_COLD;
+
+// The operands are evaluated once, into copies declared without evaluating
+// them so that disabled sites still skip them, and only captured on failure.
+#define dare_assert_compare_at(LEVEL, X, OP, Y, MSG, CODE) { \
+  __typeof__(((void) 0, (X))) dare_x; \
+  __typeof__(((void) 0, (Y))) dare_y; \
+  if (dare_assert_enabled(LEVEL) && dare_site_failed(LEVEL, CODE, \
+      !((dare_x = (X)) OP (dare_y = (Y))))) { \
+    dare_thrown = dare_throw_detail(MSG, CODE, DARE_LINE, \
+      "expected %s " #OP " %s, got %v vs %v", 4, \
+      (struct dare_arg const[]){ dare_arg_str(#X), dare_arg_str(#Y), \
+                                 dare_arg(dare_x), dare_arg(dare_y) }); \
+    goto dare_failure; \
+  } \
+}
+
+/*!
+ * This macro throws an Exception with message and class code if its arguments
+ * are not equal.
+ *
+ * Like the other comparison assertions below, it evaluates each argument once
+ * and, when it fails, sets the detail of the Exception to the expressions and
+ * their values.
+ */
+#define assert_equal(X, Y, MSG, CODE) \
+  assert_equal_at(DARE_ASSERT_NORMAL, X, Y, MSG, CODE)
+#define assert_equal_at(LEVEL, X, Y, MSG, CODE) \
+  dare_assert_compare_at(LEVEL, X, ==, Y, MSG, CODE)
+
+/*!
+ * This macro throws an Exception with message and class code if its arguments
+ * are equal.
+ */
+#define assert_not_equal(X, Y, MSG, CODE) \
+  assert_not_equal_at(DARE_ASSERT_NORMAL, X, Y, MSG, CODE)
+#define assert_not_equal_at(LEVEL, X, Y, MSG, CODE) \
+  dare_assert_compare_at(LEVEL, X, !=, Y, MSG, CODE)
+
+/*!
+ * This macro throws an Exception with message and class code if its first
+ * argument is greater than or equal the second.
+ */
+#define assert_lt(X, Y, MSG, CODE) \
+  assert_lt_at(DARE_ASSERT_NORMAL, X, Y, MSG, CODE)
+#define assert_lt_at(LEVEL, X, Y, MSG, CODE) \
+  dare_assert_compare_at(LEVEL, X, <, Y, MSG, CODE)
+
+/*!
+ * This macro throws an Exception with message and class code if its first
+ * argument is less than or equal the second.
+ */
+#define assert_gt(X, Y, MSG, CODE) \
+  assert_gt_at(DARE_ASSERT_NORMAL, X, Y, MSG, CODE)
+#define assert_gt_at(LEVEL, X, Y, MSG, CODE) \
+  dare_assert_compare_at(LEVEL, X, >, Y, MSG, CODE)
+
+/*!
+ * This macro throws an Exception with message and class code if its first
+ * argument is greater than the second.
+ */
+#define assert_le(X, Y, MSG, CODE) \
+  assert_le_at(DARE_ASSERT_NORMAL, X, Y, MSG, CODE)
+#define assert_le_at(LEVEL, X, Y, MSG, CODE) \
+  dare_assert_compare_at(LEVEL, X, <=, Y, MSG, CODE)
+
+/*!
+ * This macro throws an Exception with message and class code if its first
+ * argument is less than the second.
+ */
+#define assert_ge(X, Y, MSG, CODE) \
+  assert_ge_at(DARE_ASSERT_NORMAL, X, Y, MSG, CODE)
+#define assert_ge_at(LEVEL, X, Y, MSG, CODE) \
+  dare_assert_compare_at(LEVEL, X, >=, Y, MSG, CODE)
+
+/*!
+ * This macro throws an Exception with message and class code if its string
+ * arguments are not equal.
+ */
+#define assert_str_equal(X, Y, MSG, CODE) \
+  assert_str_equal_at(DARE_ASSERT_NORMAL, X, Y, MSG, CODE)
+#define assert_str_equal_at(LEVEL, X, Y, MSG, CODE) { \
+  assert_false_at(LEVEL, strcmp(X, Y), MSG, CODE) \
+}
+
+/*!
+ * This macro throws an Exception with message and class code if its string
+ * arguments are equal.
+ */
+#define assert_str_not_equal(X, Y, MSG, CODE) \
+  assert_str_not_equal_at(DARE_ASSERT_NORMAL, X, Y, MSG, CODE)
+#define assert_str_not_equal_at(LEVEL, X, Y, MSG, CODE) { \
+  assert_true_at(LEVEL, strcmp(X, Y), MSG, CODE) \
+}
+
+/*
+ * Array assertions.
+ *
+ * These check every element of an array at once with SSE2 or AVX2 kernels,
+ * picked when the program starts for the processor it runs on, and throw a
+ * single Exception for the first element that fails, with its position in
+ * the field "index" and, for numbers, its value in the field "value".
+ */
+
+//! The instruction sets the array kernels can use.
+enum dare_isa {
+  DARE_ISA_SCALAR,
+  DARE_ISA_SSE2,
+  DARE_ISA_AVX2,
+  DARE_ISA_BEST,
+};
+
+/*!
+ * Choose the kernels used by the array assertions, the best available by
+ * default.
+ *
+ * \param isa The most advanced instruction set to be used, a dare_isa.
+ * \return    The instruction set actually used, limited by the processor.
+ */
+int dare_array_use(int isa);
+
+/*
+ * The kernels return the index of the first element failing their checks or
+ * the number of elements if none does.
+ */
+size_t dare_out_of_range_f64(double const *a, size_t n, double lo, double hi);
+size_t dare_out_of_range_f32(float const *a, size_t n, float lo, float hi);
+size_t dare_out_of_range_i32(int32_t const *a, size_t n, int32_t lo,
+                             int32_t hi);
+size_t dare_out_of_range_i64(int64_t const *a, size_t n, int64_t lo,
+                             int64_t hi);
+size_t dare_not_finite_f64(double const *a, size_t n);
+size_t dare_not_finite_f32(float const *a, size_t n);
+size_t dare_first_null(void const *const *a, size_t n);
+size_t dare_unsorted_f64(double const *a, size_t n);
+size_t dare_unsorted_f32(float const *a, size_t n);
+size_t dare_unsorted_i32(int32_t const *a, size_t n);
+size_t dare_unsorted_i64(int64_t const *a, size_t n);
+size_t dare_mismatch(void const *a, void const *b, size_t size);
+
+#define dare_out_of_range(A, N, LO, HI) _Generic((A), \
+    double *: dare_out_of_range_f64, \
+    double const *: dare_out_of_range_f64, \
+    float *: dare_out_of_range_f32, \
+    float const *: dare_out_of_range_f32, \
+    int32_t *: dare_out_of_range_i32, \
+    int32_t const *: dare_out_of_range_i32, \
+    int64_t *: dare_out_of_range_i64, \
+    int64_t const *: dare_out_of_range_i64)(A, N, LO, HI)
+
+#define dare_not_finite(A, N) _Generic((A), \
+    double *: dare_not_finite_f64, \
+    double const *: dare_not_finite_f64, \
+    float *: dare_not_finite_f32, \
+    float const *: dare_not_finite_f32)(A, N)
+
+#define dare_unsorted(A, N) _Generic((A), \
+    double *: dare_unsorted_f64, \
+    double const *: dare_unsorted_f64, \
+    float *: dare_unsorted_f32, \
+    float const *: dare_unsorted_f32, \
+    int32_t *: dare_unsorted_i32, \
+    int32_t const *: dare_unsorted_i32, \
+    int64_t *: dare_unsorted_i64, \
+    int64_t const *: dare_unsorted_i64)(A, N)
+
+#define dare_set_value(E, KEY, V) _Generic((V), \
+    float: dare_set_double, \
+    double: dare_set_double, \
+    default: dare_set_int)(E, KEY, V)
+
+/*!
+ * Create a new Exception for the element of an array that failed an array
+ * assertion and add the line where it was thrown.
+ *
+ * This is the out-of-line failure path of the array assertions, do not call
+ * it directly.
+ */
+Exception dare_throw_element(char const *msg, int code, char const *line,
+                             size_t index) DARE_COLD;
+
+/*
+ * The operands of the array assertions are only evaluated once they are
+ * known to be enabled, so the wrappers declare their copy of the array with
+ * __typeof__ and assign it inside FIND.
+ */
+#define dare_assert_array_at(LEVEL, N, FIND, MSG, CODE, ...) { \
+  if (dare_assert_enabled(LEVEL)) { \
+    size_t dare_n, dare_at; \
+    if (dare_site_check(LEVEL, CODE, 1, \
+                        (dare_n = (N), (dare_at = (FIND)) < dare_n))) { \
+      dare_thrown = dare_throw_element(MSG, CODE, DARE_LINE, dare_at); \
+      __VA_ARGS__; \
+      goto dare_failure; \
+    } \
+  } \
+}
+
+/*!
+ * This macro throws an Exception with message and class code if any of the
+ * first N elements of an array of double, float, int32_t or int64_t is not
+ * between LO and HI, both included.
+ */
+#define assert_all_in_range(A, N, LO, HI, MSG, CODE) \
+  assert_all_in_range_at(DARE_ASSERT_NORMAL, A, N, LO, HI, MSG, CODE)
+#define assert_all_in_range_at(LEVEL, A, N, LO, HI, MSG, CODE) { \
+  __typeof__(((void) 0, (A))) dare_a; \
+  dare_assert_array_at(LEVEL, N, \
+                       dare_out_of_range(dare_a = (A), dare_n, LO, HI), \
+                       MSG, CODE, \
+                       dare_set_value(dare_thrown, "value", dare_a[dare_at])) \
+}
+
+/*!
+ * This macro throws an Exception with message and class code if any of the
+ * first N elements of an array of double or float is infinite or NaN.
+ */
+#define assert_all_finite(A, N, MSG, CODE) \
+  assert_all_finite_at(DARE_ASSERT_NORMAL, A, N, MSG, CODE)
+#define assert_all_finite_at(LEVEL, A, N, MSG, CODE) { \
+  __typeof__(((void) 0, (A))) dare_a; \
+  dare_assert_array_at(LEVEL, N, dare_not_finite(dare_a = (A), dare_n), \
+                       MSG, CODE, \
+                       dare_set_value(dare_thrown, "value", dare_a[dare_at])) \
+}
+
+/*!
+ * This macro throws an Exception with message and class code if any of the
+ * first N elements of an array of pointers is NULL.
+ */
+#define assert_all_not_null(A, N, MSG, CODE) \
+  assert_all_not_null_at(DARE_ASSERT_NORMAL, A, N, MSG, CODE)
+#define assert_all_not_null_at(LEVEL, A, N, MSG, CODE) { \
+  dare_assert_array_at(LEVEL, N, \
+                       dare_first_null((void const *const *) (A), dare_n), \
+                       MSG, CODE, dare_noop) \
+}
+
+/*!
+ * This macro throws an Exception with message and class code if the first N
+ * elements of an array of double, float, int32_t or int64_t are not in
+ * ascending order. The index is of the first element less than the one
+ * before it.
+ */
+#define assert_sorted(A, N, MSG, CODE) \
+  assert_sorted_at(DARE_ASSERT_NORMAL, A, N, MSG, CODE)
+#define assert_sorted_at(LEVEL, A, N, MSG, CODE) { \
+  __typeof__(((void) 0, (A))) dare_a; \
+  dare_assert_array_at(LEVEL, N, dare_unsorted(dare_a = (A), dare_n), \
+                       MSG, CODE, \
+                       dare_set_value(dare_thrown, "value", dare_a[dare_at])) \
+}
+
+/*!
+ * This macro throws an Exception with message and class code if the first
+ * SIZE bytes at A and B differ. The index is of the first byte that differs
+ * and the field "value" holds the byte at A.
+ */
+#define assert_mem_equal(A, B, SIZE, MSG, CODE) \
+  assert_mem_equal_at(DARE_ASSERT_NORMAL, A, B, SIZE, MSG, CODE)
+#define assert_mem_equal_at(LEVEL, A, B, SIZE, MSG, CODE) { \
+  unsigned char const *dare_a; \
+  dare_assert_array_at(LEVEL, SIZE, \
+                       dare_mismatch(dare_a = (void const *) (A), (B), dare_n), \
+                       MSG, CODE, \
+                       dare_set_int(dare_thrown, "value", dare_a[dare_at])) \
+}
+
+/*
+ * Non-local propagation.
+ *
+ * The macros with the suffix `_jmp` are an opt-in alternative for deep call
+ * chains. A try_jmp() block establishes a handler in a thread-local stack and
+ * throw_jmp() jumps straight to the nearest one with longjmp(), so functions
+ * in between neither return nor check an Exception. They may return anything
+ * or nothing at all.
+ *
+ * Because the stack frames in between are discarded, the lines they would add
+ * are not in the stacktrace and the resources they hold must be registered
+ * with cleanup_jmp(). Do not leave a try_jmp() or a cleanup_jmp() block with
+ * return, break or goto, and declare volatile the local variables changed
+ * inside a try_jmp() block and read in its catch_jmp() block.
+ */
+
+//! A cleanup action registered by an intermediate frame.
+struct dare_cleanup {
+  void (*fn)(void *);
+  void *arg;
+  struct dare_cleanup *prev;
+};
+
+//! A handler established by try_jmp().
+struct dare_handler {
+  jmp_buf env;
+  Exception exception;
+  struct dare_cleanup *cleanup;
+  unsigned context;
+  struct dare_deadline deadline;
+  struct dare_handler *prev;
+};
+
+//! The innermost handler and cleanup action of the calling thread.
+extern _Thread_local struct dare_handler *dare_handler_top;
+extern _Thread_local struct dare_cleanup *dare_cleanup_top;
+
+/*!
+ * Run the cleanup actions registered after the nearest handler and jump to it
+ * with the given Exception.
+ *
+ * If there is no handler the stacktrace is printed to stderr and the program
+ * is aborted.
+ *
+ * \param e The Exception to be thrown.
+ */
+void dare_throw_jmp(Exception e) DARE_COLD __attribute__((noreturn));
+
+static inline void dare_handler_push(struct dare_handler *h) {
+  h->exception = SUCCESS;
+  h->cleanup = dare_cleanup_top;
+  h->context = dare_context.depth;
+  h->deadline = dare_deadline;
+  h->prev = dare_handler_top;
+  dare_handler_top = h;
+}
+
+static inline void dare_handler_pop(struct dare_handler *h) {
+  dare_handler_top = h->prev;
+}
+
+static inline void dare_cleanup_push(struct dare_cleanup *c,
+                                     void (*fn)(void *), void *arg) {
+  c->fn = fn;
+  c->arg = arg;
+  c->prev = dare_cleanup_top;
+  dare_cleanup_top = c;
+}
+
+static inline void dare_cleanup_pop(struct dare_cleanup *c, int run) {
+  dare_cleanup_top = c->prev;
+  if (run) c->fn(c->arg);
+}
+
+/*!
+ * This macro defines a try clause that establishes a handler for the
+ * Exceptions thrown with throw_jmp(), check_jmp() and rethrow_jmp() by the
+ * BLOCK or any function called from it.
+ *
+ * It must be followed by a catch_jmp() clause.
+ *
+ * \example
+ * try_jmp (
+ *     parse(input); // may throw from any depth
+ * ) catch_jmp (
+ *     print_stacktrace(EVAR);
+ *     cancel(EVAR);
+ * )
+ */
+#define try_jmp(...) { \
+  struct dare_handler dare_handler; \
+  dare_handler_push(&dare_handler); \
+  if (setjmp(dare_handler.env) == 0) { \
+    __VA_ARGS__ \
+    dare_handler_pop(&dare_handler); \
+  } else
+
+/*!
+ * This macro defines the catch clause of a try_jmp() clause, which runs with
+ * the Exception in EVAR when one is thrown.
+ *
+ * The handler is already removed from the stack here, so the Exception may be
+ * returned, rethrown to an outer handler or cancelled.
+ */
+#define catch_jmp(...) { \
+    Exception EVAR = dare_handler.exception; \
+    __VA_ARGS__ \
+  } \
+}
+
+/*!
+ * This macro throws a new Exception with a message and a class code to the
+ * nearest try_jmp() handler.
+ */
+#define throw_jmp(MSG, CODE) dare_throw_jmp(dare_throw(MSG, CODE, DARE_LINE))
+
+/*!
+ * This macro throws a new Exception with a class code and a message formatted
+ * like printf() to the nearest try_jmp() handler.
+ */
+#define throwf_jmp(CODE, ...) \
+  dare_throw_jmp(dare_throwf(DARE_LINE, CODE, __VA_ARGS__))
+
+/*!
+ * This macro works like throwf_jmp(), but formats the message lazily like in
+ * throwf_lazy().
+ */
+#define throwf_lazy_jmp(CODE, ...) ( \
+  dare_check_format(__VA_ARGS__), \
+  dare_throw_jmp(dare_throw_lazy(DARE_LINE, CODE, dare_lazy_args(__VA_ARGS__))))
+
+/*!
+ * This macro checks the Exception returned by its argument and, if there is
+ * one, throws it to the nearest try_jmp() handler.
+ *
+ * It bridges functions that return Exceptions into the non-local mode.
+ */
+#define check_jmp(EXPR) { \
+  Exception dare_checked = EXPR; \
+  if (dare_unlikely(dare_checked != SUCCESS)) \
+    dare_throw_jmp(dare_rethrow(dare_checked, DARE_LINE)); \
+}
+
+/*!
+ * This macro throws a caught Exception again to the nearest try_jmp()
+ * handler, adding the current line to its stacktrace.
+ */
+#define rethrow_jmp(E) dare_throw_jmp(dare_rethrow(E, DARE_LINE))
+
+/*!
+ * This macro registers FN(ARG) to be called when BLOCK ends, either normally
+ * or because an Exception was thrown through it with throw_jmp().
+ *
+ * \example
+ * char *buffer = malloc(size);
+ * cleanup_jmp(free, buffer,
+ *     fill(buffer); // may throw
+ *     consume(buffer);
+ * )
+ */
+#define cleanup_jmp(FN, ARG, ...) { \
+  struct dare_cleanup dare_cleanup; \
+  dare_cleanup_push(&dare_cleanup, FN, ARG); \
+  __VA_ARGS__ \
+  dare_cleanup_pop(&dare_cleanup, 1); \
+}
+
+
+/*
+ * Queues.
+ *
+ * A lock-free queue hands Exceptions from any number of threads to a single
+ * collector thread. It is intrusive: each Exception has a link of its own, so
+ * pushing never allocates and never blocks, and an Exception can only be in
+ * one queue at a time. The collector takes them in batches, and may sleep on
+ * an eventfd while the queue is empty.
+ */
+
+//! The link of an Exception in a queue.
+struct dare_link {
+  struct dare_link *_Atomic next;
+};
+
+//! A multi-producer single-consumer queue of Exceptions.
+struct dare_queue {
+  struct dare_link *_Atomic head;  //< the last pushed, where producers link
+  struct dare_link *tail;          //< the next to be popped, by the consumer
+  struct dare_link stub;
+  _Atomic int sleeping;            //< whether the consumer waits on fd
+  int fd;                          //< the eventfd signalled when it sleeps
+};
+
+/*!
+ * Initialize an empty queue.
+ *
+ * \param q The queue.
+ * \return  0 on success or -1 if its eventfd cannot be created.
+ */
+int dare_queue_init(struct dare_queue *q);
+
+/*!
+ * Cancel the Exceptions left in a queue and close its eventfd.
+ *
+ * \param q The queue, which must not be used by any thread anymore.
+ */
+void dare_queue_destroy(struct dare_queue *q);
+
+/*!
+ * Push an Exception into a queue, handing it over to the consumer. It may be
+ * called from any thread.
+ *
+ * Frozen Exceptions are refused, since they may be pushed by each of their
+ * consumers and their link cannot change; they are left to the caller.
+ *
+ * \param q The queue.
+ * \param e The Exception, which must not be in another queue.
+ * \return  0 if it was pushed, -1 if it was refused.
+ */
+int dare_queue_push(struct dare_queue *q, Exception e);
+
+/*!
+ * Pop up to max Exceptions from a queue, in the order they were pushed by
+ * each producer, without waiting. Only the consumer may call it.
+ *
+ * \param q   The queue.
+ * \param out Where the Exceptions are stored.
+ * \param max How many Exceptions fit in out.
+ * \return    How many Exceptions were popped.
+ */
+size_t dare_queue_pop(struct dare_queue *q, Exception *out, size_t max);
+
+/*!
+ * Pop up to max Exceptions from a queue like dare_queue_pop(), sleeping on
+ * its eventfd while the queue is empty.
+ *
+ * \param q          The queue.
+ * \param out        Where the Exceptions are stored.
+ * \param max        How many Exceptions fit in out.
+ * \param timeout_ms How long to wait at most, or -1 to wait forever.
+ * \return           How many Exceptions were popped, 0 on timeout.
+ */
+size_t dare_queue_wait(struct dare_queue *q, Exception *out, size_t max,
+                       int timeout_ms);
+
+
+/*
+ * Parallel loops.
+ *
+ * A pool of threads runs the iterations of a loop in chunks. Each thread
+ * takes the chunks of its own share from the front, and steals half of what
+ * is left of another share from the back when its own runs out. The body of
+ * the loop returns an Exception for a chunk that fails.
+ */
+
+//! How the failures of a parallel loop are reported.
+enum dare_failures {
+  DARE_FIRST_FAILURE, //< the first one, cancelling the chunks not started
+  DARE_ALL_FAILURES,  //< all of them in an aggregate, running every chunk
+};
+
+//! The iterations of a parallel loop, from begin up to but excluding end.
+struct dare_range {
+  size_t begin;
+  size_t end;
+  size_t grain;                 //< iterations per chunk, 0 to pick one
+  enum dare_failures failures;
+};
+
+//! A range stopping at the first failure.
+#define DARE_RANGE(BEGIN, END, GRAIN) \
+  ((struct dare_range){ (BEGIN), (END), (GRAIN), DARE_FIRST_FAILURE })
+
+//! The body of a parallel loop, run for the iterations of a chunk.
+typedef Exception (*dare_chunk_fn)(size_t begin, size_t end, void *arg);
+
+//! A pool of threads for parallel loops.
+struct dare_pool;
+
+/*!
+ * Start a pool of threads.
+ *
+ * \param threads How many threads run each loop, counting the one calling
+ *                dare_parallel_for(), or 0 for one per processor online.
+ * \return        The pool or NULL in case of error.
+ */
+struct dare_pool *dare_pool_new(int threads);
+
+/*!
+ * Stop the threads of a pool and free it.
+ *
+ * \param pool The pool, which must not be running a loop.
+ */
+void dare_pool_free(struct dare_pool *pool);
+
+/*!
+ * Run fn over a range of iterations split in chunks, on the threads of a pool
+ * and the one calling it, and wait until they are done.
+ *
+ * Each Exception returned gets the fields "worker" and "chunk", the indexes of
+ * the thread and the chunk that failed. Stopping at the first failure, the
+ * others are cancelled; reporting all of them, they are aggregated like by
+ * check_all(), with the chunk in the field "index" of each child.
+ *
+ * Loops run one at a time on each pool, and a loop started from the body of
+ * another runs on the calling thread alone.
+ *
+ * \param pool  The pool, or NULL for one shared pool with a thread per
+ *              processor online, started on first use.
+ * \param range The iterations, the size of the chunks and what to report.
+ * \param fn    The body of the loop.
+ * \param arg   Passed to each call of fn.
+ * \return      SUCCESS or the failure reported.
+ */
+Exception dare_parallel_for(struct dare_pool *pool, struct dare_range range,
+                            dare_chunk_fn fn, void *arg);
+
+/*!
+ * Check whether the parallel loop the calling thread runs a chunk for has
+ * been cancelled by a failure, so long chunks can stop early.
+ *
+ * \return Non zero if it has been cancelled, zero otherwise.
+ */
+int dare_cancelled(void);
+
+/*
+ * Circuit breakers.
+ *
+ * A breaker counts the failures of a class of codes reported from catch
+ * blocks over a sliding window, in counters sharded by thread. When they
+ * reach a threshold it opens and check_breaker() throws a single static
+ * Exception at once, instead of calling a dependency that keeps failing.
+ * After a cooldown it lets one call through as a probe, and only what the
+ * thread running the probe reports counts: a success closes it, a failure
+ * keeps it open for another cooldown.
+ */
+
+#ifndef DARE_BREAKER_SHARDS
+#define DARE_BREAKER_SHARDS 16
+#endif
+//! The sliding window is split in this many buckets, dropped one at a time.
+#define DARE_BREAKER_BUCKETS 8
+
+//! A circuit breaker, defined with DARE_BREAKER() or DARE_CODE_BREAKER().
+struct dare_breaker {
+  _Atomic int open;              //< zero while closed, read by check_breaker()
+  _Atomic int64_t opened_at;     //< when it opened or was last probed
+  _Atomic uintptr_t prober;      //< the thread running the probe, 0 if none
+  Exception _Atomic rejection;   //< thrown while it is open
+  char const *name;
+  int first;                     //< the codes counted, from first to last
+  int last;
+  int threshold;                 //< failures in a window opening it
+  int64_t window_ns;
+  int64_t cooldown_ns;           //< time open before a probe
+  struct {
+    _Atomic uint64_t buckets[DARE_BREAKER_BUCKETS];
+  } __attribute__((aligned(64))) shards[DARE_BREAKER_SHARDS];
+};
+
+/*!
+ * Define a breaker counting the failures of CLASS and its subclasses, which
+ * opens when THRESHOLD of them happen within WINDOW_NS nanoseconds and lets a
+ * probe through every COOLDOWN_NS nanoseconds while open. Declare it with
+ * extern struct dare_breaker NAME to use it in other source files.
+ *
+ * \example
+ * DARE_BREAKER(DATABASE, DB_ERROR, 20, 1000000000, 5000000000);
+ */
+#define DARE_BREAKER(NAME, CLASS, THRESHOLD, WINDOW_NS, COOLDOWN_NS) \
+  struct dare_breaker NAME = { .name = #NAME, \
+    .first = CLASS##_FIRST, .last = CLASS##_LAST, .threshold = (THRESHOLD), \
+    .window_ns = (WINDOW_NS), .cooldown_ns = (COOLDOWN_NS) }
+
+//! Define a breaker counting the failures with a single code.
+#define DARE_CODE_BREAKER(NAME, CODE, THRESHOLD, WINDOW_NS, COOLDOWN_NS) \
+  struct dare_breaker NAME = { .name = #NAME, \
+    .first = (CODE), .last = (CODE), .threshold = (THRESHOLD), \
+    .window_ns = (WINDOW_NS), .cooldown_ns = (COOLDOWN_NS) }
+
+/*!
+ * Count a failure caught from the calls a breaker guards, if its code is one
+ * the breaker counts, opening the breaker when it reaches the threshold.
+ * While it is open, only the failure of the probe is taken into account.
+ *
+ * \param b The breaker.
+ * \param e The Exception caught, only its own code is looked at.
+ * \return  Non zero if it was counted, zero otherwise.
+ */
+int dare_breaker_failure(struct dare_breaker *b, Exception e) DARE_COLD;
+
+/*!
+ * Close a breaker and forget the failures it counted.
+ *
+ * \param b The breaker.
+ */
+void dare_breaker_close(struct dare_breaker *b);
+
+/*!
+ * Close an open breaker if the calling thread runs its probe.
+ *
+ * This is the out-of-line path of dare_breaker_success(), do not call it
+ * directly.
+ */
+void dare_breaker_probe_passed(struct dare_breaker *b) DARE_COLD;
+
+/*!
+ * Report that a call a breaker guards succeeded, which closes it if it is
+ * open and the call was its probe. While it is closed this is a single load.
+ *
+ * \param b The breaker.
+ */
+static inline void dare_breaker_success(struct dare_breaker *b) {
+  if (dare_unlikely(b->open)) dare_breaker_probe_passed(b);
+}
+
+/*!
+ * Check whether a breaker is open.
+ *
+ * \param b The breaker.
+ * \return  Non zero if it is open, zero otherwise.
+ */
+static inline int dare_breaker_is_open(struct dare_breaker *b) {
+  return b->open;
+}
+
+/*!
+ * Decide whether a call may go through an open breaker as a probe.
+ *
+ * This is the out-of-line path of check_breaker(), do not call it directly.
+ *
+ * \return SUCCESS for a probe, or the static Exception of the breaker.
+ */
+Exception dare_breaker_enter(struct dare_breaker *b) DARE_COLD;
+
+/*!
+ * This macro throws the static Exception of a breaker, with the code
+ * DARE_CIRCUIT_OPEN_EXCEPTION and the name of the breaker in the field
+ * "breaker", while it is open and no probe is due. While it is closed it
+ * costs a load and a compare.
+ *
+ * The Exception is shared by every throw, has no lines and cancelling it does
+ * nothing.
+ *
+ * \example
+ * try (
+ *     check_breaker(DATABASE)
+ *     check(query(db, sql))
+ *     dare_breaker_success(&DATABASE);
+ * ) catch (
+ *     dare_breaker_failure(&DATABASE, EVAR);
+ *     return EVAR;
+ * )
+ */
+#define check_breaker(NAME) { \
+  if (dare_unlikely((NAME).open)) { \
+    dare_thrown = dare_breaker_enter(&(NAME)); \
+    if (dare_thrown != SUCCESS) goto dare_failure; \
+  } \
 }
 
 #endif
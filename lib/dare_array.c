@@ -0,0 +1,601 @@
+/*
+MIT License
+
+Copyright (c) 2022-2023 Roger W. P. da Silva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "dare.h"
+#include <math.h>
+#include <stdatomic.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DARE_HAVE_X86 1
+#include <immintrin.h>
+#endif
+
+/*
+ * Every kernel returns the index of the first element that fails its check,
+ * or the number of elements if none does. The vector kernels test blocks of
+ * several registers at once and hand over to the scalar ones from the first
+ * block with a failure, which find its exact index.
+ */
+
+#define SCALAR_RANGE(NAME, TYPE) \
+static size_t NAME(TYPE const *a, size_t i, size_t n, TYPE lo, TYPE hi) { \
+	for (; i < n; i++) \
+		if (!(a[i] >= lo && a[i] <= hi)) return i; \
+	return n; \
+}
+
+#define SCALAR_SORTED(NAME, TYPE) \
+static size_t NAME(TYPE const *a, size_t i, size_t n) { \
+	for (i = i ? i : 1; i < n; i++) \
+		if (a[i] < a[i - 1]) return i; \
+	return n; \
+}
+
+SCALAR_RANGE(range_f64_from, double)
+SCALAR_RANGE(range_f32_from, float)
+SCALAR_RANGE(range_i32_from, int32_t)
+SCALAR_RANGE(range_i64_from, int64_t)
+SCALAR_SORTED(sorted_f64_from, double)
+SCALAR_SORTED(sorted_f32_from, float)
+SCALAR_SORTED(sorted_i32_from, int32_t)
+SCALAR_SORTED(sorted_i64_from, int64_t)
+
+static size_t finite_f64_from(double const *a, size_t i, size_t n) {
+	for (; i < n; i++)
+		if (!isfinite(a[i])) return i;
+	return n;
+}
+
+static size_t finite_f32_from(float const *a, size_t i, size_t n) {
+	for (; i < n; i++)
+		if (!isfinite(a[i])) return i;
+	return n;
+}
+
+static size_t null_from(void const *const *a, size_t i, size_t n) {
+	for (; i < n; i++)
+		if (!a[i]) return i;
+	return n;
+}
+
+static size_t mismatch_from(unsigned char const *a, unsigned char const *b,
+                            size_t i, size_t n) {
+	for (; i < n; i++)
+		if (a[i] != b[i]) return i;
+	return n;
+}
+
+static size_t range_f64_scalar(double const *a, size_t n, double lo, double hi) {
+	return range_f64_from(a, 0, n, lo, hi);
+}
+
+static size_t range_f32_scalar(float const *a, size_t n, float lo, float hi) {
+	return range_f32_from(a, 0, n, lo, hi);
+}
+
+static size_t range_i32_scalar(int32_t const *a, size_t n, int32_t lo,
+                               int32_t hi) {
+	return range_i32_from(a, 0, n, lo, hi);
+}
+
+static size_t range_i64_scalar(int64_t const *a, size_t n, int64_t lo,
+                               int64_t hi) {
+	return range_i64_from(a, 0, n, lo, hi);
+}
+
+static size_t finite_f64_scalar(double const *a, size_t n) {
+	return finite_f64_from(a, 0, n);
+}
+
+static size_t finite_f32_scalar(float const *a, size_t n) {
+	return finite_f32_from(a, 0, n);
+}
+
+static size_t null_scalar(void const *const *a, size_t n) {
+	return null_from(a, 0, n);
+}
+
+static size_t sorted_f64_scalar(double const *a, size_t n) {
+	return sorted_f64_from(a, 0, n);
+}
+
+static size_t sorted_f32_scalar(float const *a, size_t n) {
+	return sorted_f32_from(a, 0, n);
+}
+
+static size_t sorted_i32_scalar(int32_t const *a, size_t n) {
+	return sorted_i32_from(a, 0, n);
+}
+
+static size_t sorted_i64_scalar(int64_t const *a, size_t n) {
+	return sorted_i64_from(a, 0, n);
+}
+
+static size_t mismatch_scalar(void const *a, void const *b, size_t size) {
+	return mismatch_from(a, b, 0, size);
+}
+
+struct kernels {
+	size_t (*range_f64)(double const *, size_t, double, double);
+	size_t (*range_f32)(float const *, size_t, float, float);
+	size_t (*range_i32)(int32_t const *, size_t, int32_t, int32_t);
+	size_t (*range_i64)(int64_t const *, size_t, int64_t, int64_t);
+	size_t (*finite_f64)(double const *, size_t);
+	size_t (*finite_f32)(float const *, size_t);
+	size_t (*null)(void const *const *, size_t);
+	size_t (*sorted_f64)(double const *, size_t);
+	size_t (*sorted_f32)(float const *, size_t);
+	size_t (*sorted_i32)(int32_t const *, size_t);
+	size_t (*sorted_i64)(int64_t const *, size_t);
+	size_t (*mismatch)(void const *, void const *, size_t);
+};
+
+static struct kernels const scalar_kernels = {
+	range_f64_scalar, range_f32_scalar, range_i32_scalar, range_i64_scalar,
+	finite_f64_scalar, finite_f32_scalar, null_scalar,
+	sorted_f64_scalar, sorted_f32_scalar, sorted_i32_scalar, sorted_i64_scalar,
+	mismatch_scalar,
+};
+
+#ifdef DARE_HAVE_X86
+/*
+ * SSE2 kernels, four registers per block. There is no 64 bit integer compare
+ * before SSE4.2, so those checks stay scalar.
+ */
+#define SSE2 __attribute__((target("sse2")))
+
+SSE2 static size_t range_f64_sse2(double const *a, size_t n, double lo,
+                                  double hi) {
+	__m128d l = _mm_set1_pd(lo), h = _mm_set1_pd(hi);
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m128d ok = _mm_set1_pd(-1.0);
+		for (int j = 0; j < 8; j += 2) {
+			__m128d x = _mm_loadu_pd(a + i + j);
+			ok = _mm_and_pd(ok, _mm_and_pd(_mm_cmpge_pd(x, l), _mm_cmple_pd(x, h)));
+		}
+		if (_mm_movemask_pd(ok) != 0x3) break;
+	}
+	return range_f64_from(a, i, n, lo, hi);
+}
+
+SSE2 static size_t range_f32_sse2(float const *a, size_t n, float lo,
+                                  float hi) {
+	__m128 l = _mm_set1_ps(lo), h = _mm_set1_ps(hi);
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		__m128 ok = _mm_set1_ps(-1.0f);
+		for (int j = 0; j < 16; j += 4) {
+			__m128 x = _mm_loadu_ps(a + i + j);
+			ok = _mm_and_ps(ok, _mm_and_ps(_mm_cmpge_ps(x, l), _mm_cmple_ps(x, h)));
+		}
+		if (_mm_movemask_ps(ok) != 0xF) break;
+	}
+	return range_f32_from(a, i, n, lo, hi);
+}
+
+SSE2 static size_t range_i32_sse2(int32_t const *a, size_t n, int32_t lo,
+                                  int32_t hi) {
+	__m128i l = _mm_set1_epi32(lo), h = _mm_set1_epi32(hi);
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		__m128i bad = _mm_setzero_si128();
+		for (int j = 0; j < 16; j += 4) {
+			__m128i x = _mm_loadu_si128((__m128i const *) (a + i + j));
+			bad = _mm_or_si128(bad, _mm_or_si128(_mm_cmpgt_epi32(l, x),
+			                                     _mm_cmpgt_epi32(x, h)));
+		}
+		if (_mm_movemask_epi8(bad)) break;
+	}
+	return range_i32_from(a, i, n, lo, hi);
+}
+
+SSE2 static size_t finite_f64_sse2(double const *a, size_t n) {
+	__m128d zero = _mm_setzero_pd();
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m128d ok = _mm_set1_pd(-1.0);
+		for (int j = 0; j < 8; j += 2) {
+			__m128d x = _mm_loadu_pd(a + i + j);
+			// x - x is 0 for finite numbers and NaN for the others
+			ok = _mm_and_pd(ok, _mm_cmpeq_pd(_mm_sub_pd(x, x), zero));
+		}
+		if (_mm_movemask_pd(ok) != 0x3) break;
+	}
+	return finite_f64_from(a, i, n);
+}
+
+SSE2 static size_t finite_f32_sse2(float const *a, size_t n) {
+	__m128 zero = _mm_setzero_ps();
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		__m128 ok = _mm_set1_ps(-1.0f);
+		for (int j = 0; j < 16; j += 4) {
+			__m128 x = _mm_loadu_ps(a + i + j);
+			ok = _mm_and_ps(ok, _mm_cmpeq_ps(_mm_sub_ps(x, x), zero));
+		}
+		if (_mm_movemask_ps(ok) != 0xF) break;
+	}
+	return finite_f32_from(a, i, n);
+}
+
+SSE2 static size_t null_sse2(void const *const *a, size_t n) {
+	size_t const lanes = 16 / sizeof *a;
+	__m128i zero = _mm_setzero_si128();
+	size_t i = 0;
+	for (; i + 4 * lanes <= n; i += 4 * lanes) {
+		__m128i bad = _mm_setzero_si128();
+		for (size_t j = 0; j < 4 * lanes; j += lanes) {
+			__m128i x = _mm_loadu_si128((__m128i const *) (a + i + j));
+			__m128i eq = _mm_cmpeq_epi32(x, zero);
+			// a 64 bit pointer is null when both of its halves are zero
+			if (sizeof *a == 8)
+				eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, 0xB1));
+			bad = _mm_or_si128(bad, eq);
+		}
+		if (_mm_movemask_epi8(bad)) break;
+	}
+	return null_from(a, i, n);
+}
+
+SSE2 static size_t sorted_f64_sse2(double const *a, size_t n) {
+	size_t i = 0;
+	for (; i + 9 <= n; i += 8) {
+		__m128d bad = _mm_setzero_pd();
+		for (int j = 0; j < 8; j += 2)
+			bad = _mm_or_pd(bad, _mm_cmplt_pd(_mm_loadu_pd(a + i + j + 1),
+			                                  _mm_loadu_pd(a + i + j)));
+		if (_mm_movemask_pd(bad)) break;
+	}
+	return sorted_f64_from(a, i, n);
+}
+
+SSE2 static size_t sorted_f32_sse2(float const *a, size_t n) {
+	size_t i = 0;
+	for (; i + 17 <= n; i += 16) {
+		__m128 bad = _mm_setzero_ps();
+		for (int j = 0; j < 16; j += 4)
+			bad = _mm_or_ps(bad, _mm_cmplt_ps(_mm_loadu_ps(a + i + j + 1),
+			                                  _mm_loadu_ps(a + i + j)));
+		if (_mm_movemask_ps(bad)) break;
+	}
+	return sorted_f32_from(a, i, n);
+}
+
+SSE2 static size_t sorted_i32_sse2(int32_t const *a, size_t n) {
+	size_t i = 0;
+	for (; i + 17 <= n; i += 16) {
+		__m128i bad = _mm_setzero_si128();
+		for (int j = 0; j < 16; j += 4) {
+			__m128i x = _mm_loadu_si128((__m128i const *) (a + i + j));
+			__m128i y = _mm_loadu_si128((__m128i const *) (a + i + j + 1));
+			bad = _mm_or_si128(bad, _mm_cmpgt_epi32(x, y));
+		}
+		if (_mm_movemask_epi8(bad)) break;
+	}
+	return sorted_i32_from(a, i, n);
+}
+
+SSE2 static size_t mismatch_sse2(void const *a, void const *b, size_t size) {
+	unsigned char const *x = a, *y = b;
+	size_t i = 0;
+	for (; i + 64 <= size; i += 64) {
+		__m128i eq = _mm_set1_epi8(-1);
+		for (int j = 0; j < 64; j += 16)
+			eq = _mm_and_si128(eq, _mm_cmpeq_epi8(
+				_mm_loadu_si128((__m128i const *) (x + i + j)),
+				_mm_loadu_si128((__m128i const *) (y + i + j))));
+		if (_mm_movemask_epi8(eq) != 0xFFFF) break;
+	}
+	return mismatch_from(x, y, i, size);
+}
+
+static struct kernels const sse2_kernels = {
+	range_f64_sse2, range_f32_sse2, range_i32_sse2, range_i64_scalar,
+	finite_f64_sse2, finite_f32_sse2, null_sse2,
+	sorted_f64_sse2, sorted_f32_sse2, sorted_i32_sse2, sorted_i64_scalar,
+	mismatch_sse2,
+};
+
+/*
+ * AVX2 kernels, four registers per block.
+ */
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 static size_t range_f64_avx2(double const *a, size_t n, double lo,
+                                  double hi) {
+	__m256d l = _mm256_set1_pd(lo), h = _mm256_set1_pd(hi);
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		__m256d ok = _mm256_set1_pd(-1.0);
+		for (int j = 0; j < 16; j += 4) {
+			__m256d x = _mm256_loadu_pd(a + i + j);
+			ok = _mm256_and_pd(ok, _mm256_and_pd(_mm256_cmp_pd(x, l, _CMP_GE_OQ),
+			                                     _mm256_cmp_pd(x, h, _CMP_LE_OQ)));
+		}
+		if (_mm256_movemask_pd(ok) != 0xF) break;
+	}
+	return range_f64_from(a, i, n, lo, hi);
+}
+
+AVX2 static size_t range_f32_avx2(float const *a, size_t n, float lo,
+                                  float hi) {
+	__m256 l = _mm256_set1_ps(lo), h = _mm256_set1_ps(hi);
+	size_t i = 0;
+	for (; i + 32 <= n; i += 32) {
+		__m256 ok = _mm256_set1_ps(-1.0f);
+		for (int j = 0; j < 32; j += 8) {
+			__m256 x = _mm256_loadu_ps(a + i + j);
+			ok = _mm256_and_ps(ok, _mm256_and_ps(_mm256_cmp_ps(x, l, _CMP_GE_OQ),
+			                                     _mm256_cmp_ps(x, h, _CMP_LE_OQ)));
+		}
+		if (_mm256_movemask_ps(ok) != 0xFF) break;
+	}
+	return range_f32_from(a, i, n, lo, hi);
+}
+
+AVX2 static size_t range_i32_avx2(int32_t const *a, size_t n, int32_t lo,
+                                  int32_t hi) {
+	__m256i l = _mm256_set1_epi32(lo), h = _mm256_set1_epi32(hi);
+	size_t i = 0;
+	for (; i + 32 <= n; i += 32) {
+		__m256i bad = _mm256_setzero_si256();
+		for (int j = 0; j < 32; j += 8) {
+			__m256i x = _mm256_loadu_si256((__m256i const *) (a + i + j));
+			bad = _mm256_or_si256(bad, _mm256_or_si256(_mm256_cmpgt_epi32(l, x),
+			                                           _mm256_cmpgt_epi32(x, h)));
+		}
+		if (!_mm256_testz_si256(bad, bad)) break;
+	}
+	return range_i32_from(a, i, n, lo, hi);
+}
+
+AVX2 static size_t range_i64_avx2(int64_t const *a, size_t n, int64_t lo,
+                                  int64_t hi) {
+	__m256i l = _mm256_set1_epi64x(lo), h = _mm256_set1_epi64x(hi);
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		__m256i bad = _mm256_setzero_si256();
+		for (int j = 0; j < 16; j += 4) {
+			__m256i x = _mm256_loadu_si256((__m256i const *) (a + i + j));
+			bad = _mm256_or_si256(bad, _mm256_or_si256(_mm256_cmpgt_epi64(l, x),
+			                                           _mm256_cmpgt_epi64(x, h)));
+		}
+		if (!_mm256_testz_si256(bad, bad)) break;
+	}
+	return range_i64_from(a, i, n, lo, hi);
+}
+
+AVX2 static size_t finite_f64_avx2(double const *a, size_t n) {
+	__m256d zero = _mm256_setzero_pd();
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		__m256d ok = _mm256_set1_pd(-1.0);
+		for (int j = 0; j < 16; j += 4) {
+			__m256d x = _mm256_loadu_pd(a + i + j);
+			ok = _mm256_and_pd(ok, _mm256_cmp_pd(_mm256_sub_pd(x, x), zero,
+			                                     _CMP_EQ_OQ));
+		}
+		if (_mm256_movemask_pd(ok) != 0xF) break;
+	}
+	return finite_f64_from(a, i, n);
+}
+
+AVX2 static size_t finite_f32_avx2(float const *a, size_t n) {
+	__m256 zero = _mm256_setzero_ps();
+	size_t i = 0;
+	for (; i + 32 <= n; i += 32) {
+		__m256 ok = _mm256_set1_ps(-1.0f);
+		for (int j = 0; j < 32; j += 8) {
+			__m256 x = _mm256_loadu_ps(a + i + j);
+			ok = _mm256_and_ps(ok, _mm256_cmp_ps(_mm256_sub_ps(x, x), zero,
+			                                     _CMP_EQ_OQ));
+		}
+		if (_mm256_movemask_ps(ok) != 0xFF) break;
+	}
+	return finite_f32_from(a, i, n);
+}
+
+AVX2 static size_t null_avx2(void const *const *a, size_t n) {
+	size_t const lanes = 32 / sizeof *a;
+	__m256i zero = _mm256_setzero_si256();
+	size_t i = 0;
+	for (; i + 4 * lanes <= n; i += 4 * lanes) {
+		__m256i bad = _mm256_setzero_si256();
+		for (size_t j = 0; j < 4 * lanes; j += lanes) {
+			__m256i x = _mm256_loadu_si256((__m256i const *) (a + i + j));
+			bad = _mm256_or_si256(bad, sizeof *a == 8
+				? _mm256_cmpeq_epi64(x, zero) : _mm256_cmpeq_epi32(x, zero));
+		}
+		if (!_mm256_testz_si256(bad, bad)) break;
+	}
+	return null_from(a, i, n);
+}
+
+AVX2 static size_t sorted_f64_avx2(double const *a, size_t n) {
+	size_t i = 0;
+	for (; i + 17 <= n; i += 16) {
+		__m256d bad = _mm256_setzero_pd();
+		for (int j = 0; j < 16; j += 4)
+			bad = _mm256_or_pd(bad, _mm256_cmp_pd(_mm256_loadu_pd(a + i + j + 1),
+			                                      _mm256_loadu_pd(a + i + j),
+			                                      _CMP_LT_OQ));
+		if (_mm256_movemask_pd(bad)) break;
+	}
+	return sorted_f64_from(a, i, n);
+}
+
+AVX2 static size_t sorted_f32_avx2(float const *a, size_t n) {
+	size_t i = 0;
+	for (; i + 33 <= n; i += 32) {
+		__m256 bad = _mm256_setzero_ps();
+		for (int j = 0; j < 32; j += 8)
+			bad = _mm256_or_ps(bad, _mm256_cmp_ps(_mm256_loadu_ps(a + i + j + 1),
+			                                      _mm256_loadu_ps(a + i + j),
+			                                      _CMP_LT_OQ));
+		if (_mm256_movemask_ps(bad)) break;
+	}
+	return sorted_f32_from(a, i, n);
+}
+
+AVX2 static size_t sorted_i32_avx2(int32_t const *a, size_t n) {
+	size_t i = 0;
+	for (; i + 33 <= n; i += 32) {
+		__m256i bad = _mm256_setzero_si256();
+		for (int j = 0; j < 32; j += 8) {
+			__m256i x = _mm256_loadu_si256((__m256i const *) (a + i + j));
+			__m256i y = _mm256_loadu_si256((__m256i const *) (a + i + j + 1));
+			bad = _mm256_or_si256(bad, _mm256_cmpgt_epi32(x, y));
+		}
+		if (!_mm256_testz_si256(bad, bad)) break;
+	}
+	return sorted_i32_from(a, i, n);
+}
+
+AVX2 static size_t sorted_i64_avx2(int64_t const *a, size_t n) {
+	size_t i = 0;
+	for (; i + 17 <= n; i += 16) {
+		__m256i bad = _mm256_setzero_si256();
+		for (int j = 0; j < 16; j += 4) {
+			__m256i x = _mm256_loadu_si256((__m256i const *) (a + i + j));
+			__m256i y = _mm256_loadu_si256((__m256i const *) (a + i + j + 1));
+			bad = _mm256_or_si256(bad, _mm256_cmpgt_epi64(x, y));
+		}
+		if (!_mm256_testz_si256(bad, bad)) break;
+	}
+	return sorted_i64_from(a, i, n);
+}
+
+AVX2 static size_t mismatch_avx2(void const *a, void const *b, size_t size) {
+	unsigned char const *x = a, *y = b;
+	size_t i = 0;
+	for (; i + 128 <= size; i += 128) {
+		__m256i eq = _mm256_set1_epi8(-1);
+		for (int j = 0; j < 128; j += 32)
+			eq = _mm256_and_si256(eq, _mm256_cmpeq_epi8(
+				_mm256_loadu_si256((__m256i const *) (x + i + j)),
+				_mm256_loadu_si256((__m256i const *) (y + i + j))));
+		if ((unsigned) _mm256_movemask_epi8(eq) != 0xFFFFFFFF) break;
+	}
+	return mismatch_from(x, y, i, size);
+}
+
+static struct kernels const avx2_kernels = {
+	range_f64_avx2, range_f32_avx2, range_i32_avx2, range_i64_avx2,
+	finite_f64_avx2, finite_f32_avx2, null_avx2,
+	sorted_f64_avx2, sorted_f32_avx2, sorted_i32_avx2, sorted_i64_avx2,
+	mismatch_avx2,
+};
+#endif
+
+// Replaced by dare_array_use() while other threads may be running checks.
+static struct kernels const *_Atomic kernels = &scalar_kernels;
+
+static struct kernels const *current(void) {
+	return atomic_load_explicit(&kernels, memory_order_relaxed);
+}
+
+static void use(struct kernels const *k) {
+	atomic_store_explicit(&kernels, k, memory_order_relaxed);
+}
+
+int dare_array_use(int isa) {
+#ifdef DARE_HAVE_X86
+	__builtin_cpu_init();
+	if (isa >= DARE_ISA_AVX2 && __builtin_cpu_supports("avx2")) {
+		use(&avx2_kernels);
+		return DARE_ISA_AVX2;
+	}
+	if (isa >= DARE_ISA_SSE2 && __builtin_cpu_supports("sse2")) {
+		use(&sse2_kernels);
+		return DARE_ISA_SSE2;
+	}
+#else
+	(void) isa;
+#endif
+	use(&scalar_kernels);
+	return DARE_ISA_SCALAR;
+}
+
+// Pick the best kernels before main().
+__attribute__((constructor))
+static void select_kernels(void) {
+	dare_array_use(DARE_ISA_BEST);
+}
+
+size_t dare_out_of_range_f64(double const *a, size_t n, double lo, double hi) {
+	return current()->range_f64(a, n, lo, hi);
+}
+
+size_t dare_out_of_range_f32(float const *a, size_t n, float lo, float hi) {
+	return current()->range_f32(a, n, lo, hi);
+}
+
+size_t dare_out_of_range_i32(int32_t const *a, size_t n, int32_t lo,
+                             int32_t hi) {
+	return current()->range_i32(a, n, lo, hi);
+}
+
+size_t dare_out_of_range_i64(int64_t const *a, size_t n, int64_t lo,
+                             int64_t hi) {
+	return current()->range_i64(a, n, lo, hi);
+}
+
+size_t dare_not_finite_f64(double const *a, size_t n) {
+	return current()->finite_f64(a, n);
+}
+
+size_t dare_not_finite_f32(float const *a, size_t n) {
+	return current()->finite_f32(a, n);
+}
+
+size_t dare_first_null(void const *const *a, size_t n) {
+	return current()->null(a, n);
+}
+
+size_t dare_unsorted_f64(double const *a, size_t n) {
+	return current()->sorted_f64(a, n);
+}
+
+size_t dare_unsorted_f32(float const *a, size_t n) {
+	return current()->sorted_f32(a, n);
+}
+
+size_t dare_unsorted_i32(int32_t const *a, size_t n) {
+	return current()->sorted_i32(a, n);
+}
+
+size_t dare_unsorted_i64(int64_t const *a, size_t n) {
+	return current()->sorted_i64(a, n);
+}
+
+size_t dare_mismatch(void const *a, void const *b, size_t size) {
+	return current()->mismatch(a, b, size);
+}
+
+Exception dare_throw_element(char const *msg, int code, char const *line,
+                             size_t index) {
+	Exception e = dare_throw(msg, code, line);
+	dare_set_int(e, "index", (int64_t) index);
+	return e;
+}
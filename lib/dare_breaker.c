@@ -0,0 +1,160 @@
+/*
+MIT License
+
+Copyright (c) 2022-2023 Roger W. P. da Silva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "dare.h"
+#include <pthread.h>
+#include <stdatomic.h>
+
+/*
+ * Each bucket packs the index of the slice of time it counts, modulo 2^40,
+ * with the count, so a thread finding a bucket of an older slice restarts it
+ * with a single compare and swap.
+ */
+#define COUNT_BITS 24
+#define COUNT_MASK ((UINT64_C(1) << COUNT_BITS) - 1)
+#define SLICE_MASK (UINT64_MAX >> COUNT_BITS)
+
+static pthread_mutex_t rejection_lock = PTHREAD_MUTEX_INITIALIZER;
+static _Atomic unsigned next_shard = 0;
+static _Thread_local int shard = -1;
+// Its address tells the threads apart, to know which one runs a probe.
+static _Thread_local char self;
+
+static int my_shard(void) {
+	if (shard < 0)
+		shard = atomic_fetch_add_explicit(&next_shard, 1, memory_order_relaxed)
+		      % DARE_BREAKER_SHARDS;
+	return shard;
+}
+
+static uint64_t slice_of(struct dare_breaker const *b, int64_t now) {
+	int64_t slice_ns = b->window_ns / DARE_BREAKER_BUCKETS;
+	return (uint64_t) (now / (slice_ns > 0 ? slice_ns : 1)) & SLICE_MASK;
+}
+
+static void count(struct dare_breaker *b, uint64_t slice) {
+	_Atomic uint64_t *bucket =
+		&b->shards[my_shard()].buckets[slice % DARE_BREAKER_BUCKETS];
+	uint64_t old = atomic_load_explicit(bucket, memory_order_relaxed);
+	uint64_t next;
+	do {
+		if (old >> COUNT_BITS != slice)
+			next = slice << COUNT_BITS | 1;
+		else
+			next = old + ((old & COUNT_MASK) != COUNT_MASK);
+	} while (!atomic_compare_exchange_weak_explicit(bucket, &old, next,
+	         memory_order_relaxed, memory_order_relaxed));
+}
+
+// Sum the buckets of every shard counting one of the last slices.
+static int64_t total(struct dare_breaker *b, uint64_t slice) {
+	int64_t sum = 0;
+	for (int i = 0; i < DARE_BREAKER_SHARDS; i++)
+		for (int j = 0; j < DARE_BREAKER_BUCKETS; j++) {
+			uint64_t bucket = atomic_load_explicit(&b->shards[i].buckets[j],
+			                                       memory_order_relaxed);
+			if (((slice - (bucket >> COUNT_BITS)) & SLICE_MASK)
+			    < DARE_BREAKER_BUCKETS)
+				sum += bucket & COUNT_MASK;
+		}
+	return sum;
+}
+
+// The Exception thrown while open is made once, by the first to open it.
+static void make_rejection(struct dare_breaker *b) {
+	pthread_mutex_lock(&rejection_lock);
+	if (!atomic_load_explicit(&b->rejection, memory_order_relaxed)) {
+		Exception e = new_exception(DARE_CIRCUIT_OPEN_MSG,
+		                            DARE_CIRCUIT_OPEN_EXCEPTION, NULL);
+		dare_set_str(e, "breaker", b->name);
+		atomic_store_explicit(&b->rejection, dare_retain_forever(e),
+		                      memory_order_release);
+	}
+	pthread_mutex_unlock(&rejection_lock);
+}
+
+int dare_breaker_failure(struct dare_breaker *b, Exception e) {
+	if (!b || !dare_is_a(e, b->first, b->last)) return 0;
+
+	int64_t now = dare_deadline_now();
+	if (atomic_load_explicit(&b->open, memory_order_acquire)) {
+		// The probe failed, wait for another cooldown.
+		uintptr_t prober = (uintptr_t) &self;
+		if (atomic_compare_exchange_strong_explicit(&b->prober, &prober, 0,
+		    memory_order_relaxed, memory_order_relaxed))
+			atomic_store_explicit(&b->opened_at, now, memory_order_relaxed);
+		return 1;
+	}
+	uint64_t slice = slice_of(b, now);
+	count(b, slice);
+	if (total(b, slice) >= b->threshold) {
+		if (!atomic_load_explicit(&b->rejection, memory_order_acquire))
+			make_rejection(b);
+		atomic_store_explicit(&b->opened_at, now, memory_order_relaxed);
+		atomic_store_explicit(&b->prober, 0, memory_order_relaxed);
+		atomic_store_explicit(&b->open, 1, memory_order_release);
+	}
+	return 1;
+}
+
+void dare_breaker_probe_passed(struct dare_breaker *b) {
+	uintptr_t prober = (uintptr_t) &self;
+	if (atomic_compare_exchange_strong_explicit(&b->prober, &prober, 0,
+	    memory_order_relaxed, memory_order_relaxed))
+		dare_breaker_close(b);
+}
+
+void dare_breaker_close(struct dare_breaker *b) {
+	int open = 1;
+	if (!atomic_compare_exchange_strong_explicit(&b->open, &open, 0,
+	    memory_order_acq_rel, memory_order_relaxed))
+		return;
+	for (int i = 0; i < DARE_BREAKER_SHARDS; i++)
+		for (int j = 0; j < DARE_BREAKER_BUCKETS; j++)
+			atomic_store_explicit(&b->shards[i].buckets[j], 0,
+			                      memory_order_relaxed);
+}
+
+/*
+ * The first call to find the cooldown over moves it forward and goes through
+ * as the probe, its thread becoming the prober; if the probe never reports
+ * back, another goes through after the next cooldown and takes over.
+ */
+Exception dare_breaker_enter(struct dare_breaker *b) {
+	if (!atomic_load_explicit(&b->open, memory_order_acquire)) return SUCCESS;
+
+	int64_t now = dare_deadline_now();
+	int64_t opened_at = atomic_load_explicit(&b->opened_at,
+	                                         memory_order_relaxed);
+	if (now - opened_at >= b->cooldown_ns
+	    && atomic_compare_exchange_strong_explicit(&b->opened_at, &opened_at,
+	       now, memory_order_relaxed, memory_order_relaxed)) {
+		atomic_store_explicit(&b->prober, (uintptr_t) &self,
+		                      memory_order_relaxed);
+		return SUCCESS;
+	}
+
+	Exception e = atomic_load_explicit(&b->rejection, memory_order_acquire);
+	return e ? e : new_exception(DARE_CIRCUIT_OPEN_MSG,
+	                             DARE_CIRCUIT_OPEN_EXCEPTION, NULL);
+}
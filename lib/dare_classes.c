@@ -0,0 +1,64 @@
+/*
+MIT License
+
+Copyright (c) 2022-2023 Roger W. P. da Silva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "dare.h"
+
+#ifdef DARE_HAVE_CLASSES
+extern struct dare_class const __start_dare_classes[] __attribute__((weak));
+extern struct dare_class const __stop_dare_classes[] __attribute__((weak));
+
+// Find the narrowest class containing the codes from first to last, other
+// than the class skipped.
+static struct dare_class const *narrowest(int first, int last,
+                                          struct dare_class const *skip) {
+	struct dare_class const *best = NULL;
+	struct dare_class const *c;
+	for (c = __start_dare_classes; c < __stop_dare_classes; c++) {
+		if (c == skip || first < c->first || last > c->last) continue;
+		if (!best || (unsigned) c->last - (unsigned) c->first
+		           < (unsigned) best->last - (unsigned) best->first)
+			best = c;
+	}
+	return best;
+}
+#else
+static struct dare_class const *narrowest(int first, int last,
+                                          struct dare_class const *skip) {
+	(void) first;
+	(void) last;
+	(void) skip;
+	return NULL;
+}
+#endif
+
+struct dare_class const *get_class(Exception e) {
+	if (!e) return NULL;
+
+	int code = get_code(e);
+	return narrowest(code, code, NULL);
+}
+
+struct dare_class const *dare_class_parent(struct dare_class const *c) {
+	if (!c) return NULL;
+	return narrowest(c->first, c->last, c);
+}
@@ -0,0 +1,59 @@
+/*
+MIT License
+
+Copyright (c) 2022-2023 Roger W. P. da Silva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "dare.h"
+#include <time.h>
+
+_Thread_local struct dare_deadline dare_deadline = { INT64_MAX, 0, 0 };
+
+int64_t dare_deadline_now(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+	return (int64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+struct dare_deadline dare_deadline_enter(int64_t budget_ns) {
+	struct dare_deadline saved = dare_deadline;
+	int64_t now = dare_deadline_now();
+	if (budget_ns < 0) budget_ns = 0;
+	int64_t at = budget_ns < INT64_MAX - now ? now + budget_ns : INT64_MAX;
+	if (at < saved.at) {
+		dare_deadline.at = at;
+		dare_deadline.start = now;
+		dare_deadline.budget = budget_ns;
+	}
+	return saved;
+}
+
+int64_t dare_deadline_left(void) {
+	if (dare_deadline.at == INT64_MAX) return INT64_MAX;
+	int64_t left = dare_deadline.at - dare_deadline_now();
+	return left > 0 ? left : 0;
+}
+
+Exception dare_throw_timeout(char const *line) {
+	Exception e = new_exception(DARE_TIMEOUT_MSG, DARE_TIMEOUT_EXCEPTION, NULL);
+	dare_set_int(e, "elapsed", dare_deadline_now() - dare_deadline.start);
+	dare_set_int(e, "budget", dare_deadline.budget);
+	return add_line(e, line);
+}
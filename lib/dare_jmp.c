@@ -0,0 +1,50 @@
+/*
+MIT License
+
+Copyright (c) 2022-2023 Roger W. P. da Silva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "dare.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+_Thread_local struct dare_handler *dare_handler_top = NULL;
+_Thread_local struct dare_cleanup *dare_cleanup_top = NULL;
+
+void dare_throw_jmp(Exception e) {
+	struct dare_handler *h = dare_handler_top;
+	if (!h) {
+		fputs("Uncaught ", stderr);
+		fprint_stacktrace(stderr, e);
+		abort();
+	}
+
+	while (dare_cleanup_top != h->cleanup) {
+		struct dare_cleanup *c = dare_cleanup_top;
+		dare_cleanup_top = c->prev;
+		c->fn(c->arg);
+	}
+
+	dare_context.depth = h->context;
+	dare_deadline = h->deadline;
+	dare_handler_top = h->prev;
+	h->exception = e;
+	longjmp(h->env, 1);
+}
@@ -0,0 +1,293 @@
+/*
+MIT License
+
+Copyright (c) 2022-2023 Roger W. P. da Silva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "dare.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+// A loop being run, shared by the threads of a pool.
+struct job {
+	dare_chunk_fn fn;
+	void *arg;
+	size_t begin;
+	size_t end;
+	size_t grain;
+	enum dare_failures failures;
+	_Atomic int cancelled;
+	pthread_mutex_t lock; // guards failure
+	Exception failure;
+};
+
+struct worker {
+	struct dare_pool *pool;
+	int index;
+	pthread_t thread;
+};
+
+/*
+ * The chunks left of the share of each thread are packed as the first one in
+ * the high half of a word and the end in the low half, so the owner and the
+ * thieves take them with a single compare and swap.
+ */
+struct dare_pool {
+	pthread_mutex_t run;  // taken while a loop runs
+	pthread_mutex_t lock; // guards the fields below
+	pthread_cond_t start;
+	pthread_cond_t done;
+	struct job *job;
+	unsigned generation;
+	int busy;
+	int stopping;
+	int threads;
+	struct worker *workers;
+	_Atomic uint64_t shares[];
+};
+
+static _Thread_local struct job *current = NULL;
+
+#define SHARE(FIRST, END) ((uint64_t) (FIRST) << 32 | (uint32_t) (END))
+#define SHARE_FIRST(S) ((uint32_t) ((S) >> 32))
+#define SHARE_END(S) ((uint32_t) (S))
+
+// Take the first chunk of the own share.
+static int take(_Atomic uint64_t *share, uint32_t *chunk) {
+	uint64_t s = atomic_load_explicit(share, memory_order_relaxed);
+	do {
+		if (SHARE_FIRST(s) >= SHARE_END(s)) return 0;
+	} while (!atomic_compare_exchange_weak_explicit(share, &s,
+	         SHARE(SHARE_FIRST(s) + 1, SHARE_END(s)), memory_order_relaxed,
+	         memory_order_relaxed));
+	*chunk = SHARE_FIRST(s);
+	return 1;
+}
+
+// Steal the second half of the share of another thread, keeping its first
+// chunk to run now and the rest as the own share.
+static int steal(struct dare_pool *pool, int self, uint32_t *chunk) {
+	for (int i = 1; i < pool->threads; i++) {
+		_Atomic uint64_t *victim = &pool->shares[(self + i) % pool->threads];
+		uint64_t s = atomic_load_explicit(victim, memory_order_relaxed);
+		uint32_t first, end, half;
+		do {
+			first = SHARE_FIRST(s);
+			end = SHARE_END(s);
+			if (first >= end) break;
+			half = (end - first + 1) / 2;
+		} while (!atomic_compare_exchange_weak_explicit(victim, &s,
+		         SHARE(first, end - half), memory_order_relaxed,
+		         memory_order_relaxed));
+		if (first >= end) continue;
+
+		*chunk = end - half;
+		atomic_store_explicit(&pool->shares[self], SHARE(end - half + 1, end),
+		                      memory_order_relaxed);
+		return 1;
+	}
+	return 0;
+}
+
+static void fail(struct job *job, Exception e, int worker, uint32_t chunk) {
+	dare_set_int(e, "worker", worker);
+	dare_set_int(e, "chunk", chunk);
+
+	pthread_mutex_lock(&job->lock);
+	if (job->failures == DARE_ALL_FAILURES) {
+		job->failure = dare_collect(job->failure, e, chunk);
+	} else if (!job->failure) {
+		job->failure = e;
+		atomic_store_explicit(&job->cancelled, 1, memory_order_relaxed);
+	} else {
+		dare_release(e);
+	}
+	pthread_mutex_unlock(&job->lock);
+}
+
+static void run_chunk(struct job *job, int worker, uint32_t chunk) {
+	size_t begin = job->begin + chunk * job->grain;
+	size_t end = job->end - begin > job->grain ? begin + job->grain : job->end;
+	Exception e = job->fn(begin, end, job->arg);
+	if (dare_unlikely(e != SUCCESS)) fail(job, e, worker, chunk);
+}
+
+static void run_job(struct dare_pool *pool, struct job *job, int self) {
+	uint32_t chunk;
+	current = job;
+	while (!atomic_load_explicit(&job->cancelled, memory_order_relaxed)
+	       && (take(&pool->shares[self], &chunk) || steal(pool, self, &chunk)))
+		run_chunk(job, self, chunk);
+	current = NULL;
+}
+
+static void *work(void *arg) {
+	struct worker *w = arg;
+	struct dare_pool *pool = w->pool;
+	unsigned seen = 0;
+
+	pthread_mutex_lock(&pool->lock);
+	for (;;) {
+		while (!pool->stopping && pool->generation == seen)
+			pthread_cond_wait(&pool->start, &pool->lock);
+		if (pool->stopping) break;
+		seen = pool->generation;
+		struct job *job = pool->job;
+		pthread_mutex_unlock(&pool->lock);
+
+		run_job(pool, job, w->index);
+
+		pthread_mutex_lock(&pool->lock);
+		if (--pool->busy == 0) pthread_cond_signal(&pool->done);
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return NULL;
+}
+
+struct dare_pool *dare_pool_new(int threads) {
+	if (threads <= 0) threads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (threads <= 0) threads = 1;
+
+	struct dare_pool *pool = malloc(sizeof *pool
+	                                + threads * sizeof *pool->shares);
+	if (!pool) return NULL;
+	pool->workers = calloc(threads, sizeof *pool->workers);
+	if (!pool->workers) {
+		free(pool);
+		return NULL;
+	}
+	pthread_mutex_init(&pool->run, NULL);
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->start, NULL);
+	pthread_cond_init(&pool->done, NULL);
+	pool->job = NULL;
+	pool->generation = 0;
+	pool->busy = 0;
+	pool->stopping = 0;
+	pool->threads = 1;
+	for (int i = 0; i < threads; i++)
+		atomic_init(&pool->shares[i], 0);
+
+	// The calling thread is worker 0, so only the others are started.
+	for (int i = 1; i < threads; i++) {
+		struct worker *w = &pool->workers[i];
+		w->pool = pool;
+		w->index = i;
+		if (pthread_create(&w->thread, NULL, work, w)) break;
+		pool->threads++;
+	}
+	return pool;
+}
+
+void dare_pool_free(struct dare_pool *pool) {
+	if (!pool) return;
+
+	pthread_mutex_lock(&pool->lock);
+	pool->stopping = 1;
+	pthread_cond_broadcast(&pool->start);
+	pthread_mutex_unlock(&pool->lock);
+	for (int i = 1; i < pool->threads; i++)
+		pthread_join(pool->workers[i].thread, NULL);
+
+	pthread_mutex_destroy(&pool->run);
+	pthread_mutex_destroy(&pool->lock);
+	pthread_cond_destroy(&pool->start);
+	pthread_cond_destroy(&pool->done);
+	free(pool->workers);
+	free(pool);
+}
+
+static struct dare_pool *shared_pool = NULL;
+static pthread_once_t shared_once = PTHREAD_ONCE_INIT;
+
+static void start_shared_pool(void) {
+	shared_pool = dare_pool_new(0);
+}
+
+// Run a loop on the calling thread alone, as worker 0.
+static void run_serial(struct job *job) {
+	uint32_t chunks = (job->end - job->begin + job->grain - 1) / job->grain;
+	struct job *outer = current;
+	current = job;
+	for (uint32_t chunk = 0; chunk < chunks; chunk++) {
+		if (atomic_load_explicit(&job->cancelled, memory_order_relaxed)) break;
+		run_chunk(job, 0, chunk);
+	}
+	current = outer;
+}
+
+Exception dare_parallel_for(struct dare_pool *pool, struct dare_range range,
+                            dare_chunk_fn fn, void *arg) {
+	if (!fn || range.end <= range.begin) return SUCCESS;
+	if (!pool) {
+		pthread_once(&shared_once, start_shared_pool);
+		pool = shared_pool;
+	}
+
+	struct job job;
+	size_t n = range.end - range.begin;
+	int threads = pool ? pool->threads : 1;
+	job.fn = fn;
+	job.arg = arg;
+	job.begin = range.begin;
+	job.end = range.end;
+	job.grain = range.grain ? range.grain : (n + 4 * threads - 1) / (4 * threads);
+	if (n / job.grain >= UINT32_MAX) job.grain = n / (UINT32_MAX - 1) + 1;
+	job.failures = range.failures;
+	atomic_init(&job.cancelled, 0);
+	pthread_mutex_init(&job.lock, NULL);
+	job.failure = SUCCESS;
+
+	if (!pool || pool->threads == 1 || current) {
+		run_serial(&job);
+	} else {
+		uint32_t chunks = (n + job.grain - 1) / job.grain;
+		pthread_mutex_lock(&pool->run);
+		for (int i = 0; i < threads; i++)
+			atomic_store_explicit(&pool->shares[i],
+			                      SHARE((uint64_t) chunks * i / threads,
+			                            (uint64_t) chunks * (i + 1) / threads),
+			                      memory_order_relaxed);
+
+		pthread_mutex_lock(&pool->lock);
+		pool->job = &job;
+		pool->generation++;
+		pool->busy = threads - 1;
+		pthread_cond_broadcast(&pool->start);
+		pthread_mutex_unlock(&pool->lock);
+
+		run_job(pool, &job, 0);
+
+		pthread_mutex_lock(&pool->lock);
+		while (pool->busy)
+			pthread_cond_wait(&pool->done, &pool->lock);
+		pthread_mutex_unlock(&pool->lock);
+		pthread_mutex_unlock(&pool->run);
+	}
+
+	pthread_mutex_destroy(&job.lock);
+	return job.failure;
+}
+
+int dare_cancelled(void) {
+	return current
+	    && atomic_load_explicit(&current->cancelled, memory_order_relaxed);
+}
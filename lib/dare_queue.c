@@ -0,0 +1,144 @@
+/*
+MIT License
+
+Copyright (c) 2022-2023 Roger W. P. da Silva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "dare.h"
+#include <poll.h>
+#include <stdatomic.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Vyukov's intrusive queue: a producer swaps its link in as the head and then
+ * links the previous head to it, while the consumer follows the links from
+ * the tail. A stub link, pushed back whenever the consumer reaches the last
+ * one, keeps the queue from ever running out of links.
+ *
+ * The link is the first member of an Exception, so they convert with casts.
+ */
+static void push_link(struct dare_queue *q, struct dare_link *link) {
+	atomic_store_explicit(&link->next, NULL, memory_order_relaxed);
+	struct dare_link *prev = atomic_exchange_explicit(&q->head, link,
+	                                                  memory_order_acq_rel);
+	atomic_store_explicit(&prev->next, link, memory_order_release);
+}
+
+// Pop a link, or return NULL if the queue is empty or a push is half done.
+static struct dare_link *pop_link(struct dare_queue *q) {
+	struct dare_link *tail = q->tail;
+	struct dare_link *next = atomic_load_explicit(&tail->next,
+	                                              memory_order_acquire);
+	if (tail == &q->stub) {
+		if (!next) return NULL;
+		q->tail = tail = next;
+		next = atomic_load_explicit(&tail->next, memory_order_acquire);
+	}
+	if (next) {
+		q->tail = next;
+		return tail;
+	}
+
+	if (tail != atomic_load_explicit(&q->head, memory_order_acquire))
+		return NULL;
+	push_link(q, &q->stub);
+	next = atomic_load_explicit(&tail->next, memory_order_acquire);
+	if (!next) return NULL;
+	q->tail = next;
+	return tail;
+}
+
+int dare_queue_init(struct dare_queue *q) {
+	if (!q) return -1;
+
+	atomic_init(&q->stub.next, NULL);
+	atomic_init(&q->head, &q->stub);
+	q->tail = &q->stub;
+	atomic_init(&q->sleeping, 0);
+	q->fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	return q->fd < 0 ? -1 : 0;
+}
+
+void dare_queue_destroy(struct dare_queue *q) {
+	if (!q) return;
+
+	struct dare_link *link;
+	while ((link = pop_link(q))) cancel((Exception) link);
+	if (q->fd >= 0) close(q->fd);
+	q->fd = -1;
+}
+
+/*
+ * The producer checks whether the consumer sleeps after pushing, and the
+ * consumer checks whether the queue is empty after saying it sleeps, each
+ * behind a full fence, so at least one of them sees the other.
+ */
+int dare_queue_push(struct dare_queue *q, Exception e) {
+	if (!q || !e || is_frozen(e)) return -1;
+
+	push_link(q, (struct dare_link *) e);
+	atomic_thread_fence(memory_order_seq_cst);
+	if (atomic_load_explicit(&q->sleeping, memory_order_relaxed)) {
+		uint64_t one = 1;
+		while (write(q->fd, &one, sizeof one) < 0 && errno == EINTR)
+			continue;
+	}
+	return 0;
+}
+
+size_t dare_queue_pop(struct dare_queue *q, Exception *out, size_t max) {
+	if (!q || !out) return 0;
+
+	size_t count = 0;
+	struct dare_link *link;
+	while (count < max && (link = pop_link(q)))
+		out[count++] = (Exception) link;
+	return count;
+}
+
+static int64_t monotonic_ms(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (int64_t) now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+size_t dare_queue_wait(struct dare_queue *q, Exception *out, size_t max,
+                       int timeout_ms) {
+	size_t count = dare_queue_pop(q, out, max);
+	if (count || !max) return count;
+
+	int64_t deadline = timeout_ms < 0 ? -1 : monotonic_ms() + timeout_ms;
+	atomic_store_explicit(&q->sleeping, 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	while (!(count = dare_queue_pop(q, out, max))) {
+		int wait = -1;
+		if (deadline >= 0 && (wait = deadline - monotonic_ms()) <= 0) break;
+
+		struct pollfd p = { q->fd, POLLIN, 0 };
+		if (poll(&p, 1, wait) < 0 && errno != EINTR) break;
+		uint64_t signals;
+		ssize_t drained = read(q->fd, &signals, sizeof signals);
+		(void) drained;
+	}
+	atomic_store_explicit(&q->sleeping, 0, memory_order_relaxed);
+	return count;
+}
@@ -0,0 +1,281 @@
+/*
+MIT License
+
+Copyright (c) 2022-2023 Roger W. P. da Silva
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "dare.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <unistd.h>
+
+// A filter whose strings are not necessarily terminated, so the queries can be
+// matched in place without copying them.
+struct query {
+	char const *file;
+	size_t file_len;
+	char const *func;
+	size_t func_len;
+	int first_line;
+	int last_line;
+	int level;
+	int match_code;
+	int code;
+};
+
+// The parsing below must stay async-signal-safe, so it uses no libc at all.
+static size_t length(char const *str) {
+	size_t len = 0;
+	if (str)
+		while (str[len]) len++;
+	return len;
+}
+
+static int same(char const *str, char const *token, size_t len) {
+	size_t i;
+	for (i = 0; i < len; i++)
+		if (str[i] != token[i]) return 0;
+	return str[len] == '\0';
+}
+
+// The file matches if it is the same or if it ends with a '/' and the name.
+static int same_file(char const *file, char const *name, size_t len) {
+	size_t file_len = length(file);
+	if (file_len < len) return 0;
+	if (file_len > len && file[file_len - len - 1] != '/') return 0;
+	return same(file + file_len - len, name, len);
+}
+
+static int matches(struct dare_site const *site, struct query const *q) {
+	if (q->file && !same_file(site->file, q->file, q->file_len)) return 0;
+	if (q->func && !same(site->func, q->func, q->func_len)) return 0;
+	if (q->first_line && site->line < q->first_line) return 0;
+	if (q->last_line && site->line > q->last_line) return 0;
+	if (q->level && site->level != q->level) return 0;
+	if (q->match_code && (!site->has_code || site->code != q->code)) return 0;
+	return 1;
+}
+
+#ifdef DARE_HAVE_SITES
+extern struct dare_site __start_dare_sites[] __attribute__((weak));
+extern struct dare_site __stop_dare_sites[] __attribute__((weak));
+
+static int apply(struct query const *q, int enabled) {
+	int count = 0;
+	struct dare_site *site;
+	for (site = __start_dare_sites; site < __stop_dare_sites; site++) {
+		if (!matches(site, q)) continue;
+		site->enabled = enabled && site->compiled;
+		count++;
+	}
+	return count;
+}
+#else
+static int apply(struct query const *q, int enabled) {
+	(void) q;
+	(void) enabled;
+	return 0;
+}
+#endif
+
+int dare_sites_set(struct dare_site_filter const *filter, int enabled) {
+	if (!filter) return 0;
+
+	struct query q;
+	q.file = filter->file;
+	q.file_len = length(filter->file);
+	q.func = filter->func;
+	q.func_len = length(filter->func);
+	q.first_line = filter->first_line;
+	q.last_line = filter->last_line;
+	q.level = filter->level;
+	q.match_code = filter->match_code;
+	q.code = filter->code;
+	return apply(&q, enabled);
+}
+
+static int is_space(char c) {
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+static int is_end(char c) {
+	return c == '\0' || c == '\n' || c == ';';
+}
+
+// Read the next token, returning its length and advancing the cursor.
+static size_t next_token(char const **cursor, char const **token) {
+	char const *p = *cursor;
+	while (is_space(*p)) p++;
+	*token = p;
+	while (!is_end(*p) && !is_space(*p)) p++;
+	*cursor = p;
+	return p - *token;
+}
+
+// Parse a possibly negative decimal number, returning the characters used.
+static size_t parse_int(char const *str, size_t len, int *value) {
+	size_t i = 0;
+	int sign = 1;
+	long v = 0;
+	if (i < len && (str[i] == '-' || str[i] == '+'))
+		sign = str[i++] == '-' ? -1 : 1;
+	size_t first = i;
+	while (i < len && str[i] >= '0' && str[i] <= '9' && v < 1L << 31)
+		v = v * 10 + (str[i++] - '0');
+	if (i == first) return 0;
+	*value = sign * v;
+	return i;
+}
+
+static int keyword(char const *token, size_t len, char const *word) {
+	return len == length(word) && same(word, token, len);
+}
+
+// Parse one query, leaving the cursor at its end, and apply it.
+static int control(char const **cursor) {
+	struct query q = {0};
+	int flag = -1;
+	char const *token;
+	size_t len;
+
+	while ((len = next_token(cursor, &token))) {
+		if (flag >= 0) return -1;
+		if (len == 1 && (*token == '+' || *token == '-')) {
+			flag = *token == '+';
+			continue;
+		}
+
+		char const *value;
+		size_t value_len = next_token(cursor, &value);
+		if (!value_len) return -1;
+
+		if (keyword(token, len, "file")) {
+			q.file = value;
+			q.file_len = value_len;
+		} else if (keyword(token, len, "func")) {
+			q.func = value;
+			q.func_len = value_len;
+		} else if (keyword(token, len, "line")) {
+			size_t used = parse_int(value, value_len, &q.first_line);
+			if (!used || q.first_line <= 0) return -1;
+			q.last_line = q.first_line;
+			if (used < value_len) {
+				if (value[used] != '-') return -1;
+				size_t rest = value_len - used - 1;
+				if (rest && parse_int(value + used + 1, rest, &q.last_line) != rest)
+					return -1;
+				if (!rest) q.last_line = 0;
+			}
+		} else if (keyword(token, len, "level")) {
+			if (parse_int(value, value_len, &q.level) != value_len) return -1;
+		} else if (keyword(token, len, "code")) {
+			if (parse_int(value, value_len, &q.code) != value_len) return -1;
+			q.match_code = 1;
+		} else {
+			return -1;
+		}
+	}
+
+	if (flag < 0) return -1;
+	return apply(&q, flag);
+}
+
+int dare_sites_control(char const *query) {
+	if (!query) return -1;
+
+	int count = 0;
+	char const *cursor = query;
+	for (;;) {
+		char const *token;
+		char const *start = cursor;
+		if (next_token(&start, &token)) {
+			int matched = control(&cursor);
+			if (matched < 0) return -1;
+			count += matched;
+		} else {
+			cursor = start;
+		}
+		if (*cursor == '\0') break;
+		cursor++;
+	}
+	return count;
+}
+
+static char watched_path[4096];
+static char watched_query[16384];
+
+static void on_signal(int signo) {
+	(void) signo;
+	int saved = errno;
+	int fd = open(watched_path, O_RDONLY);
+	if (fd >= 0) {
+		size_t used = 0;
+		ssize_t n;
+		while (used < sizeof watched_query - 1
+		    && (n = read(fd, watched_query + used, sizeof watched_query - 1 - used)) > 0)
+			used += n;
+		close(fd);
+		watched_query[used] = '\0';
+		dare_sites_control(watched_query);
+	}
+	errno = saved;
+}
+
+int dare_sites_watch(char const *path, int signo) {
+	if (!path) return -1;
+
+	size_t len = length(path);
+	if (len >= sizeof watched_path) return -1;
+	memcpy(watched_path, path, len + 1);
+
+	struct sigaction action;
+	memset(&action, 0, sizeof action);
+	action.sa_handler = on_signal;
+	action.sa_flags = SA_RESTART;
+	sigemptyset(&action.sa_mask);
+	return sigaction(signo, &action, NULL);
+}
+
+#ifdef DARE_HAVE_SITES
+int dare_sites_fprint(FILE *fp) {
+	if (!fp) return 0;
+
+	int count = 0;
+	struct dare_site const *site;
+	for (site = __start_dare_sites; site < __stop_dare_sites; site++) {
+		fprintf(fp, "%s:%d [%s] level=%d ", site->file, site->line, site->func,
+		        site->level);
+		if (site->has_code)
+			fprintf(fp, "code=%d ", site->code);
+		else
+			fputs("code=? ", fp);
+		fputs(!site->compiled ? "stripped\n" : site->enabled ? "+\n" : "-\n", fp);
+		count++;
+	}
+	return count;
+}
+#else
+int dare_sites_fprint(FILE *fp) {
+	(void) fp;
+	return 0;
+}
+#endif
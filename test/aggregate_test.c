@@ -0,0 +1,120 @@
+#include "cester.h"
+#include "dare.h"
+
+CESTER_BODY(
+  static Exception validate(int value) {
+    try (
+      if (value % 3 == 0) throwf(60, "Bad value %d", value);
+    ) catch (
+      return EVAR;
+    )
+    return SUCCESS;
+  }
+
+  static Exception validate_all(int const *values, size_t count) {
+    try (
+      check_all(count, i, validate(values[i]))
+    ) catch (
+      return EVAR;
+    )
+    return SUCCESS;
+  }
+)
+
+CESTER_TEST(no_failures, ti,
+  int values[] = { 1, 2, 4, 5 };
+  cester_assert_null(validate_all(values, 4));
+)
+
+CESTER_TEST(many_failures, ti,
+  static int values[10000];
+  for (int i = 0; i < 10000; i++) values[i] = i;
+  Exception e = validate_all(values, 10000);
+  cester_assert_equal(DARE_AGGREGATE_EXCEPTION, get_code(e));
+  cester_assert_equal(3334, get_child_count(e));
+  int64_t index = 0;
+  Exception last = get_child(e, 3333);
+  cester_assert_equal(0, dare_get_int(last, "index", &index));
+  cester_assert_llong_eq(9999, index);
+  cester_assert_str_equal("Bad value 9999", get_msg(last));
+  cester_assert_equal(60, get_code(get_child(e, 0)));
+  cester_assert_null(get_child(e, 3334));
+  cancel(get_child(e, 1));
+  cester_assert_str_equal("Bad value 3", get_msg(get_child(e, 1)));
+  cancel(e);
+)
+
+CESTER_TEST(children_keep_causes, ti,
+  Exception all = new_aggregate("All", 61);
+  Exception inner = new_aggregate("Inner", 62);
+  aggregate_add(inner, new_exception("Leaf", 63, NULL));
+  Exception cause = add_line(new_exception("Cause", 64, NULL), "  at c:1");
+  cester_assert_equal(0, aggregate_add(all, new_exception("Wrapper", 65, cause)));
+  cester_assert_equal(0, aggregate_add(all, inner));
+  cester_assert_equal(2, get_child_count(all));
+  Exception wrapper = get_child(all, 0);
+  cester_assert_str_equal("Cause", get_msg(get_cause(wrapper)));
+  cester_assert_ptr_equal(get_cause(wrapper), get_root_cause(wrapper));
+  cester_assert_equal(1, get_child_count(get_child(all, 1)));
+  cester_assert_str_equal("Leaf", get_msg(get_child(get_child(all, 1), 0)));
+
+  all = compact(all);
+  cester_assert_equal(2, get_child_count(all));
+  cester_assert_str_equal("Leaf", get_msg(get_child(get_child(all, 1), 0)));
+  cancel(all);
+)
+
+CESTER_TEST(add_to_plain_exception, ti,
+  Exception plain = new_exception("Plain", 66, NULL);
+  cester_assert_equal(-1, aggregate_add(plain, new_exception("Child", 67, NULL)));
+  cester_assert_equal(0, get_child_count(plain));
+  cester_assert_equal(-1, aggregate_add(NULL, new_exception("Child", 67, NULL)));
+  cancel(plain);
+)
+
+CESTER_TEST(aggregate_stacktrace, ti,
+  int values[] = { 3, 4, 6 };
+  char *expected = ""
+  "Exception: (-1002) Some operations failed\n"
+  "  at aggregate_test.c:16\n"
+  "Failure 1 of 2: Exception: (60) Bad value 3\n"
+  "  with index=0\n"
+  "  at aggregate_test.c:7\n"
+  "Failure 2 of 2: Exception: (60) Bad value 6\n"
+  "  with index=2\n"
+  "  at aggregate_test.c:7\n";
+  Exception e = validate_all(values, 3);
+  CESTER_CAPTURE_STDOUT();
+  print_stacktrace(e);
+  cester_assert_stdout_stream_content_equal(expected);
+  CESTER_RELEASE_STDOUT();
+  cancel(e);
+)
+
+CESTER_TEST(add_rejected_releases_causes, ti,
+  Exception plain = new_exception("Plain", 66, NULL);
+  Exception cause = new_exception("Cause", 68, NULL);
+  ExceptionHandle h = get_handle(cause);
+  cester_assert_equal(-1, aggregate_add(plain, new_exception("Child", 67, cause)));
+  cester_assert_null(from_handle(h));
+  cancel(plain);
+)
+
+CESTER_TEST(children_keep_lines, ti,
+  static char const *where[] = {
+    "  at a:1", "  at a:2", "  at a:3", "  at a:4", "  at a:5", "  at a:6"
+  };
+  Exception child = new_exception("Deep", 69, NULL);
+  for (int i = 0; i < 6; i++) add_line(child, where[i]);
+  Exception all = new_aggregate("All", 61);
+  aggregate_add(all, child);
+  char *expected = ""
+  "Exception: (61) All\n"
+  "Failure 1 of 1: Exception: (69) Deep\n"
+  "  at a:1\n  at a:2\n  at a:3\n  at a:4\n  at a:5\n  at a:6\n";
+  CESTER_CAPTURE_STDOUT();
+  print_stacktrace(all);
+  cester_assert_stdout_stream_content_equal(expected);
+  CESTER_RELEASE_STDOUT();
+  cancel(all);
+)
@@ -0,0 +1,189 @@
+#include "cester.h"
+#include "dare.h"
+#include <math.h>
+
+#define SIZE 203
+
+CESTER_BODY(
+  static double f64[SIZE];
+  static float f32[SIZE];
+  static int32_t i32[SIZE];
+  static int64_t i64[SIZE];
+  static void const *ptrs[SIZE];
+  static unsigned char bytes[SIZE], other[SIZE];
+
+  static void fill(void) {
+    for (int i = 0; i < SIZE; i++) {
+      f64[i] = f32[i] = i32[i] = i64[i] = i;
+      ptrs[i] = &f64[i];
+      bytes[i] = other[i] = (unsigned char) i;
+    }
+  }
+
+  // Break each array at one index and check every kernel finds it.
+  static int kernels_find(size_t at, size_t n) {
+    fill();
+    f64[at] = -1;
+    f32[at] = -1;
+    i32[at] = -1;
+    i64[at] = -1;
+    ptrs[at] = NULL;
+    other[at] ^= 0x80;
+    size_t sorted = at ? at : n;
+    size_t expected = at < n ? at : n;
+    if (at >= n) sorted = n;
+    return dare_out_of_range(f64, n, 0.0, SIZE) == expected
+      && dare_out_of_range(f32, n, 0.0f, SIZE) == expected
+      && dare_out_of_range(i32, n, 0, SIZE) == expected
+      && dare_out_of_range(i64, n, 0, SIZE) == expected
+      && dare_first_null(ptrs, n) == expected
+      && dare_mismatch(bytes, other, n) == expected
+      && dare_unsorted(f64, n) == sorted
+      && dare_unsorted(f32, n) == sorted
+      && dare_unsorted(i32, n) == sorted
+      && dare_unsorted(i64, n) == sorted;
+  }
+
+  static int all_positions(void) {
+    for (size_t n = 0; n <= SIZE; n += n < 40 ? 1 : 17)
+      for (size_t at = 0; at < SIZE; at++)
+        if (!kernels_find(at, n)) return 0;
+    return 1;
+  }
+
+  static int evaluations;
+
+  static double const *counted(double const *values) {
+    evaluations++;
+    return values;
+  }
+
+  static size_t counted_size(size_t n) {
+    evaluations++;
+    return n;
+  }
+
+  static Exception check_values(double const *values, size_t n) {
+    try (
+      assert_all_finite(values, n, "Not finite", 70)
+      assert_all_in_range(values, n, 0.0, 100.0, "Out of range", 71)
+      assert_sorted(values, n, "Not sorted", 72)
+    ) catch (
+      return EVAR;
+    )
+    return SUCCESS;
+  }
+)
+
+CESTER_TEST(scalar_kernels, ti,
+  cester_assert_equal(DARE_ISA_SCALAR, dare_array_use(DARE_ISA_SCALAR));
+  cester_assert_true(all_positions());
+  dare_array_use(DARE_ISA_BEST);
+)
+
+CESTER_TEST(sse2_kernels, ti,
+  dare_array_use(DARE_ISA_SSE2);
+  cester_assert_true(all_positions());
+  dare_array_use(DARE_ISA_BEST);
+)
+
+CESTER_TEST(best_kernels, ti,
+  dare_array_use(DARE_ISA_BEST);
+  cester_assert_true(all_positions());
+)
+
+CESTER_TEST(finite_kernels, ti,
+  int isas[] = { DARE_ISA_SCALAR, DARE_ISA_SSE2, DARE_ISA_BEST };
+  for (int k = 0; k < 3; k++) {
+    dare_array_use(isas[k]);
+    fill();
+    cester_assert_equal(SIZE, dare_not_finite(f64, SIZE));
+    f64[150] = INFINITY;
+    f64[170] = NAN;
+    f32[33] = NAN;
+    cester_assert_equal(150, dare_not_finite(f64, SIZE));
+    cester_assert_equal(33, dare_not_finite(f32, SIZE));
+    cester_assert_equal(100, dare_out_of_range(f32 + 34, 100, 0.0f, 1000.0f));
+    cester_assert_equal(32, dare_out_of_range(f32 + 1, SIZE - 1, 0.0f, 1000.0f));
+  }
+  dare_array_use(DARE_ISA_BEST);
+)
+
+CESTER_TEST(array_assertions, ti,
+  double values[100];
+  for (int i = 0; i < 100; i++) values[i] = i;
+  cester_assert_null(check_values(values, 100));
+
+  int64_t index = 0;
+  double value = 0;
+  values[60] = 500;
+  Exception e = check_values(values, 100);
+  cester_assert_equal(71, get_code(e));
+  dare_get_int(e, "index", &index);
+  dare_get_double(e, "value", &value);
+  cester_assert_llong_eq(60, index);
+  cester_assert_double_eq(500.0, value);
+  cancel(e);
+
+  values[60] = 59.5;
+  values[61] = 59;
+  e = check_values(values, 100);
+  cester_assert_equal(72, get_code(e));
+  dare_get_int(e, "index", &index);
+  cester_assert_llong_eq(61, index);
+  cancel(e);
+
+  values[10] = NAN;
+  e = check_values(values, 100);
+  cester_assert_equal(70, get_code(e));
+  cancel(e);
+)
+
+CESTER_TEST(pointer_and_memory_assertions, ti,
+  int a = 1, b = 2;
+  int *ptrs[] = { &a, &b, NULL, &a };
+  char x[] = "same bytes here", y[] = "same bytes HERE";
+  int64_t index = 0, value = 0;
+  try (
+    assert_all_not_null(ptrs, 2, "Null", 73)
+    assert_mem_equal(x, y, 11, "Differ", 74)
+    assert_mem_equal(x, y, sizeof x, "Differ", 74)
+  ) catch (
+    cester_assert_equal(74, get_code(EVAR));
+    dare_get_int(EVAR, "index", &index);
+    dare_get_int(EVAR, "value", &value);
+    cester_assert_llong_eq(11, index);
+    cester_assert_llong_eq('h', value);
+    cancel(EVAR);
+  )
+  try (
+    assert_all_not_null(ptrs, 4, "Null", 73)
+  ) catch (
+    dare_get_int(EVAR, "index", &index);
+    cester_assert_llong_eq(2, index);
+    cancel(EVAR);
+  )
+)
+
+CESTER_TEST(stripped_array_assertions, ti,
+  double values[] = { 2, 1, NAN };
+  evaluations = 0;
+  try (
+    assert_all_finite_at(DARE_ASSERT_PARANOID, counted(values),
+                         counted_size(3), "Not finite", 70)
+    assert_sorted_at(DARE_ASSERT_PARANOID, counted(values), counted_size(3),
+                     "Not sorted", 72)
+    assert_mem_equal_at(DARE_ASSERT_PARANOID, counted(values), values,
+                        counted_size(3), "Differ", 74)
+  ) catch (
+    cancel(EVAR);
+  )
+  cester_assert_equal(0, evaluations);
+  try (
+    assert_sorted(counted(values), counted_size(3), "Not sorted", 72)
+  ) catch (
+    cester_assert_equal(72, get_code(EVAR));
+    cancel(EVAR);
+  )
+  cester_assert_equal(2, evaluations);
+)
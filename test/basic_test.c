@@ -107,3 +107,91 @@ CESTER_TEST(stacktrace, ti,
     cancel(EVAR);
   )
 )
+
+CESTER_TEST(sequential_regions, ti,
+  int caught = 0;
+  for (int i = 0; i < 10; i++) {
+    try (
+      if (i % 2) throw("Odd", i);
+    ) catch (
+      caught += get_code(EVAR);
+      cancel(EVAR);
+    )
+  }
+  try (
+    check(throw_directly())
+  ) catch (
+    caught += get_code(EVAR);
+    cancel(EVAR);
+  )
+  cester_assert_equal(1 + 3 + 5 + 7 + 9 + 10, caught);
+)
+
+CESTER_TEST(nested_regions, ti,
+  int inner = 0;
+  int outer = 0;
+  try (
+    try (
+      throw("Inner", 40);
+    ) catch (
+      inner = get_code(EVAR);
+      check_cause(EVAR, "Outer", 50)
+    )
+    outer = -1;
+  ) catch (
+    outer = get_code(EVAR);
+    cester_assert_equal(40, get_code(get_cause(EVAR)));
+    cancel(EVAR);
+  )
+  cester_assert_equal(40, inner);
+  cester_assert_equal(50, outer);
+)
+
+CESTER_BODY(
+  char order[16];
+  int done = 0;
+
+  void record(void *arg) {
+    order[done++] = *(char *) arg;
+    order[done] = '\0';
+  }
+
+  Exception defer_and_return(int fail) {
+    try_defer (
+      defer(record, "a");
+      defer(record, "b");
+      if (fail) throw("Deferred", 60);
+      defer(record, "c");
+      return SUCCESS;
+    ) catch (
+      record("!");
+      return EVAR;
+    )
+  }
+)
+
+CESTER_TEST(defer_on_success, ti,
+  done = 0;
+  cester_assert_null(defer_and_return(0));
+  cester_assert_str_equal("cba", order);
+)
+
+CESTER_TEST(defer_on_failure, ti,
+  done = 0;
+  Exception e = defer_and_return(1);
+  cester_assert_equal(60, get_code(e));
+  cester_assert_str_equal("ba!", order);
+  cancel(e);
+)
+
+CESTER_TEST(defer_overflow, ti,
+  done = 0;
+  try_defer (
+    for (int i = 0; i < DARE_DEFER_MAX + 1; i++)
+      defer(record, "x");
+  ) catch (
+    cester_assert_equal(DARE_DEFER_EXCEPTION, get_code(EVAR));
+    cester_assert_equal(DARE_DEFER_MAX + 1, done);
+    cancel(EVAR);
+  )
+)
@@ -0,0 +1,154 @@
+#define _POSIX_C_SOURCE 200809L
+#include "cester.h"
+#include "dare.h"
+#include <pthread.h>
+#include <time.h>
+
+CESTER_BODY(
+  DARE_CLASS(DB_ERROR, 4000, 4099);
+  DARE_BREAKER(DATABASE, DB_ERROR, 3, 1000000000, 20000000);
+  DARE_CODE_BREAKER(BUSY, 4001, 100, 10000000000, 10000000000);
+
+  _Atomic int calls = 0;
+
+  static void sleep_ms(long ms) {
+    struct timespec t = { 0, ms * 1000000 };
+    nanosleep(&t, NULL);
+  }
+
+  static Exception query(int code) {
+    calls++;
+    if (code) return new_exception("Query failed", code, NULL);
+    return SUCCESS;
+  }
+
+  static Exception guarded(struct dare_breaker *b, int code) {
+    try (
+      check_breaker(*b)
+      check(query(code))
+      dare_breaker_success(b);
+    ) catch (
+      dare_breaker_failure(b, EVAR);
+      return EVAR;
+    )
+    return SUCCESS;
+  }
+
+  static void *succeed_late(void *arg) {
+    dare_breaker_success(arg);
+    return NULL;
+  }
+
+  static void *fail_late(void *arg) {
+    Exception e = new_exception("Late", 4004, NULL);
+    dare_breaker_failure(arg, e);
+    cancel(e);
+    return NULL;
+  }
+
+  static void run(void *(*fn)(void *), void *arg) {
+    pthread_t thread;
+    pthread_create(&thread, NULL, fn, arg);
+    pthread_join(thread, NULL);
+  }
+
+  static void *fail_many(void *arg) {
+    for (int i = 0; i < 25; i++)
+      cancel(guarded(arg, 4001));
+    return NULL;
+  }
+)
+
+CESTER_TEST(breaker_closed, ti,
+  cester_assert_null(guarded(&DATABASE, 0));
+  Exception e = guarded(&DATABASE, 1);
+  cester_assert_equal(1, get_code(e));
+  cester_assert_false(dare_breaker_is_open(&DATABASE));
+  cancel(e);
+)
+
+CESTER_TEST(breaker_opens, ti,
+  for (int i = 0; i < 3; i++) {
+    cester_assert_false(dare_breaker_is_open(&DATABASE));
+    cancel(guarded(&DATABASE, 4002));
+  }
+  cester_assert_true(dare_breaker_is_open(&DATABASE));
+
+  calls = 0;
+  Exception e = guarded(&DATABASE, 0);
+  cester_assert_equal(0, calls);
+  cester_assert_equal(DARE_CIRCUIT_OPEN_EXCEPTION, get_code(e));
+  cester_assert_str_equal(DARE_CIRCUIT_OPEN_MSG, get_msg(e));
+  char const *name;
+  cester_assert_equal(0, dare_get_str(e, "breaker", &name));
+  cester_assert_str_equal("DATABASE", name);
+  cester_assert_true(is_frozen(e));
+  cester_assert_ptr_equal(e, guarded(&DATABASE, 0));
+  cancel(e);
+  cancel(e);
+  cester_assert_str_equal(DARE_CIRCUIT_OPEN_MSG, get_msg(e));
+  dare_breaker_close(&DATABASE);
+)
+
+CESTER_TEST(breaker_probe, ti,
+  for (int i = 0; i < 3; i++) cancel(guarded(&DATABASE, 4003));
+  cester_assert_true(dare_breaker_is_open(&DATABASE));
+  sleep_ms(40);
+
+  calls = 0;
+  cancel(guarded(&DATABASE, 4003));
+  cester_assert_equal(1, calls);
+  cester_assert_true(dare_breaker_is_open(&DATABASE));
+  cester_assert_equal(DARE_CIRCUIT_OPEN_EXCEPTION,
+                      get_code(guarded(&DATABASE, 0)));
+  cester_assert_equal(1, calls);
+
+  sleep_ms(40);
+  cester_assert_null(guarded(&DATABASE, 0));
+  cester_assert_equal(2, calls);
+  cester_assert_false(dare_breaker_is_open(&DATABASE));
+  cancel(guarded(&DATABASE, 4003));
+  cester_assert_false(dare_breaker_is_open(&DATABASE));
+  dare_breaker_close(&DATABASE);
+)
+
+CESTER_TEST(breaker_other_codes, ti,
+  for (int i = 0; i < 5; i++) cancel(guarded(&BUSY, 4002));
+  cester_assert_false(dare_breaker_is_open(&BUSY));
+  cester_assert_equal(0, dare_breaker_failure(&BUSY, NULL));
+)
+
+CESTER_TEST(breaker_threads, ti,
+  pthread_t threads[4];
+  for (int i = 0; i < 4; i++)
+    pthread_create(&threads[i], NULL, fail_many, &BUSY);
+  for (int i = 0; i < 4; i++)
+    pthread_join(threads[i], NULL);
+  cester_assert_true(dare_breaker_is_open(&BUSY));
+  dare_breaker_close(&BUSY);
+  cester_assert_false(dare_breaker_is_open(&BUSY));
+)
+
+CESTER_TEST(breaker_only_probe_counts, ti,
+  for (int i = 0; i < 3; i++) cancel(guarded(&DATABASE, 4003));
+  run(succeed_late, &DATABASE);
+  cester_assert_true(dare_breaker_is_open(&DATABASE));
+
+  sleep_ms(40);
+  run(fail_late, &DATABASE);
+  calls = 0;
+  cancel(guarded(&DATABASE, 4003));
+  cester_assert_equal(1, calls);
+
+  sleep_ms(40);
+  calls = 0;
+  try (
+    check_breaker(DATABASE)
+    run(succeed_late, &DATABASE);
+    cester_assert_true(dare_breaker_is_open(&DATABASE));
+    dare_breaker_success(&DATABASE);
+  ) catch (
+    cancel(EVAR);
+  )
+  cester_assert_false(dare_breaker_is_open(&DATABASE));
+)
@@ -0,0 +1,101 @@
+#include "cester.h"
+#include "dare.h"
+
+CESTER_BODY(
+  static Exception level(int depth) {
+    try (
+      if (depth == 0) throwf(100, "Root of %d", depth);
+      check_cause(level(depth - 1), "Wrapped", 100 + depth);
+    ) catch (
+      return EVAR;
+    )
+    return SUCCESS;
+  }
+)
+
+CESTER_TEST(root_and_depth, ti,
+  Exception e = level(5);
+  Exception root = e;
+  while (get_cause(root)) root = get_cause(root);
+  cester_assert_equal(6, get_depth(e));
+  cester_assert_ptr_equal(root, get_root_cause(e));
+  cester_assert_ptr_equal(root, get_root_cause(root));
+  cester_assert_equal(1, get_depth(root));
+  cester_assert_equal(0, get_depth(NULL));
+  cester_assert_null(get_root_cause(NULL));
+  e = compact(e);
+  cancel(e);
+)
+
+CESTER_TEST(find_by_code, ti,
+  Exception e = level(3);
+  cester_assert_ptr_equal(e, find_cause_by_code(e, 103));
+  cester_assert_equal(101, get_code(find_cause_by_code(e, 101)));
+  cester_assert_ptr_equal(get_root_cause(e), find_cause_by_code(e, 100));
+  cester_assert_null(find_cause_by_code(e, 104));
+  e = compact(e);
+  cancel(e);
+)
+
+CESTER_TEST(compact_chain, ti,
+  char long_msg[100];
+  memset(long_msg, 'm', sizeof long_msg - 1);
+  long_msg[sizeof long_msg - 1] = '\0';
+  Exception root = add_line(new_exception_owned(long_msg, 1, NULL), "  at a:1");
+  add_line(root, "  at a:2");
+  dare_set_int(root, "offset", 9);
+  Exception middle = add_line(new_exceptionf(2, root, "Middle %d", 2), "  at b:1");
+  Exception e = add_line(new_exception("Top", 3, middle), "  at c:1");
+  ExceptionHandle h = get_handle(e);
+
+  Exception flat = compact(e);
+  cester_assert_ptr_not_equal(e, flat);
+  cester_assert_null(from_handle(h));
+  cester_assert_equal(NULL_HANDLE, get_handle(flat));
+  cester_assert_equal(3, get_depth(flat));
+  cester_assert_str_equal("Top", get_msg(flat));
+  cester_assert_str_equal("Middle 2", get_msg(get_cause(flat)));
+  cester_assert_str_equal(long_msg, get_msg(get_root_cause(flat)));
+  cester_assert_ptr_equal(get_cause(get_cause(flat)), get_root_cause(flat));
+
+  int64_t offset = 0;
+  cester_assert_equal(0, dare_get_int(get_root_cause(flat), "offset", &offset));
+  cester_assert_llong_eq(9, offset);
+  cester_assert_ptr_equal(flat, compact(flat));
+
+  char *expected = ""
+  "Exception: (3) Top\n"
+  "  at c:1\n"
+  "Caused by: (2) Middle 2\n"
+  "  at b:1\n";
+  CESTER_CAPTURE_STDOUT();
+  fprint_stacktrace(stdout, flat);
+  cester_assert_stdout_stream_content_contain(expected);
+  cester_assert_stdout_stream_content_contain("  at a:1\n  at a:2\n");
+  CESTER_RELEASE_STDOUT();
+
+  cancel(get_cause(flat));
+  cancel(flat);
+)
+
+CESTER_TEST(compact_lazy, ti,
+  char name[] = "lazy";
+  Exception e = NULL;
+  try (
+    throwf_lazy(4, "Name %s", name);
+  ) catch (
+    e = compact(EVAR);
+  )
+  memcpy(name, "gone", sizeof name);
+  cester_assert_str_equal("Name lazy", get_msg(e));
+  cancel(e);
+)
+
+CESTER_TEST(compact_compacted_cause, ti,
+  Exception inner = compact(new_exception("a", 1, new_exception("b", 2, NULL)));
+  Exception e = compact(new_exception("c", 3, inner));
+  cester_assert_equal(3, get_depth(e));
+  cester_assert_str_equal("c", get_msg(e));
+  cester_assert_str_equal("b", get_msg(get_root_cause(e)));
+  cancel(e);
+)
@@ -0,0 +1,68 @@
+#include "cester.h"
+#include "dare.h"
+
+CESTER_BODY(
+  DARE_CLASS(IO_ERROR, 1000, 1999);
+  DARE_SUBCLASS(DISK_ERROR, IO_ERROR, 1100, 1199);
+  DARE_SUBCLASS(DISK_FULL, DISK_ERROR, 1101, 1101);
+  DARE_CLASS(PARSE_ERROR, 2000, 2999);
+
+  DARE_CLASS_INFO(IO_ERROR);
+  DARE_CLASS_INFO(DISK_ERROR);
+  DARE_CLASS_INFO(DISK_FULL);
+
+  static int route(int code) {
+    int route = 0;
+    try (
+      throw("Routed", code);
+    ) catch (
+      catch_classes (
+        catch_class(PARSE_ERROR, route = 1;)
+        catch_class(IO_ERROR,
+          route = 2;
+          catch_classes (
+            catch_class(DISK_ERROR, route = 3;)
+          )
+        )
+        catch_other(route = 4;)
+      )
+      cancel(EVAR);
+    )
+    return route;
+  }
+)
+
+CESTER_TEST(is_a_class, ti,
+  Exception e = new_exception("Full", DISK_FULL_FIRST, NULL);
+  cester_assert_true(is_a(e, DISK_FULL));
+  cester_assert_true(is_a(e, DISK_ERROR));
+  cester_assert_true(is_a(e, IO_ERROR));
+  cester_assert_false(is_a(e, PARSE_ERROR));
+  cester_assert_false(is_a(NULL, IO_ERROR));
+  cancel(e);
+  e = new_exception("Negative", -5, NULL);
+  cester_assert_false(is_a(e, IO_ERROR));
+  cancel(e);
+)
+
+CESTER_TEST(catch_class_routes, ti,
+  cester_assert_equal(1, route(2500));
+  cester_assert_equal(2, route(1000));
+  cester_assert_equal(3, route(1101));
+  cester_assert_equal(2, route(1999));
+  cester_assert_equal(4, route(3000));
+  cester_assert_equal(4, route(999));
+)
+
+CESTER_TEST(class_descriptors, ti,
+  Exception e = new_exception("Disk", 1150, NULL);
+  struct dare_class const *c = get_class(e);
+  cester_assert_not_null((void *) c);
+  cester_assert_str_equal("DISK_ERROR", c->name);
+  cester_assert_str_equal("IO_ERROR", dare_class_parent(c)->name);
+  cester_assert_null((void *) dare_class_parent(dare_class_parent(c)));
+  cancel(e);
+  e = new_exception("Parse", 2001, NULL);
+  cester_assert_null((void *) get_class(e));
+  cancel(e);
+)
@@ -0,0 +1,94 @@
+#include "cester.h"
+#include "dare.h"
+
+CESTER_BODY(
+  int evaluations = 0;
+
+  int next(int x) {
+    evaluations++;
+    return x;
+  }
+
+  static Exception check_total(int total, int expected) {
+    try (
+      assert_equal(total, expected, "Wrong total", 10);
+    ) catch (
+      return EVAR;
+    )
+    return SUCCESS;
+  }
+)
+
+CESTER_TEST(compare_detail, ti,
+  Exception e = check_total(7, 8);
+  cester_assert_str_equal("Wrong total", get_msg(e));
+  cester_assert_str_equal("expected total == expected, got 7 vs 8",
+                          get_detail(e));
+  cancel(e);
+)
+
+CESTER_TEST(compare_no_detail, ti,
+  Exception e = new_exception("Plain", 1, NULL);
+  cester_assert_null((void *) get_detail(e));
+  cester_assert_null((void *) get_detail(NULL));
+  cancel(e);
+)
+
+CESTER_TEST(compare_types, ti,
+  unsigned long size = 3;
+  double ratio = 0.5;
+  try (
+    assert_lt(ratio * 4, 1.5, "Too large", 11);
+  ) catch (
+    cester_assert_str_equal("expected ratio * 4 < 1.5, got 2 vs 1.5",
+                            get_detail(EVAR));
+    cancel(EVAR);
+  )
+  try (
+    assert_ge(size, 4ul, "Too small", 12);
+  ) catch (
+    cester_assert_str_equal("expected size >= 4ul, got 3 vs 4",
+                            get_detail(EVAR));
+    cancel(EVAR);
+  )
+  try (
+    assert_not_equal(size - 4, size - 4, "Same", 13);
+  ) catch (
+    cester_assert_str_equal(
+      "expected size - 4 != size - 4, got 18446744073709551615 vs "
+      "18446744073709551615", get_detail(EVAR));
+    cancel(EVAR);
+  )
+)
+
+CESTER_TEST(compare_evaluated_once, ti,
+  evaluations = 0;
+  try (
+    assert_gt(next(1), next(2), "Not greater", 14);
+  ) catch (
+    cester_assert_str_equal("expected next(1) > next(2), got 1 vs 2",
+                            get_detail(EVAR));
+    cancel(EVAR);
+  )
+  cester_assert_equal(2, evaluations);
+)
+
+CESTER_TEST(compare_compact, ti,
+  Exception e = compact(check_total(-1, 100));
+  cester_assert_str_equal("expected total == expected, got -1 vs 100",
+                          get_detail(e));
+  cancel(e);
+)
+
+CESTER_TEST(compare_stacktrace, ti,
+  char *expected = ""
+  "Exception: (10) Wrong total\n"
+  "  expected total == expected, got 2 vs 3\n"
+  "  at compare_test.c:14\n";
+  Exception e = check_total(2, 3);
+  CESTER_CAPTURE_STDOUT();
+  print_stacktrace(e);
+  cester_assert_stdout_stream_content_equal(expected);
+  CESTER_RELEASE_STDOUT();
+  cancel(e);
+)
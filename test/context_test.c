@@ -0,0 +1,101 @@
+#include "cester.h"
+#include "dare.h"
+
+CESTER_BODY(
+  static Exception load(char const *name) {
+    with_context("op", "load");
+    try (
+      if (name) throw("Not found", 30);
+    ) catch (
+      return EVAR;
+    )
+    return SUCCESS;
+  }
+
+  static Exception serve(int64_t request, char const *name) {
+    with_context_int("request", request);
+    return load(name);
+  }
+
+  static void deep(int depth) {
+    with_context_int("depth", depth);
+    if (depth == 0) throw_jmp("Bottom", 31);
+    deep(depth - 1);
+  }
+)
+
+CESTER_TEST(context_snapshot, ti,
+  Exception e = serve(42, "x");
+  cester_assert_equal(0, dare_context.depth);
+  cester_assert_equal(2, dare_context_count(e));
+  cester_assert_str_equal("request", dare_context_at(e, 0)->label);
+  cester_assert_llong_eq(42, dare_context_at(e, 0)->value);
+  cester_assert_str_equal("op", dare_context_at(e, 1)->label);
+  cester_assert_str_equal("load", dare_context_at(e, 1)->str);
+  cester_assert_null((void *) dare_context_at(e, 2));
+  cancel(e);
+)
+
+CESTER_TEST(context_push_pop, ti,
+  dare_context_push_str("user", "bob");
+  Exception outer = new_exception("Outer", 1, NULL);
+  dare_context_pop();
+  Exception bare = new_exception("Bare", 2, NULL);
+  cester_assert_equal(1, dare_context_count(outer));
+  cester_assert_equal(0, dare_context_count(bare));
+  cester_assert_equal(0, dare_context.depth);
+  cancel(outer);
+  cancel(bare);
+)
+
+CESTER_TEST(context_overflow, ti,
+  for (int i = 0; i < DARE_CONTEXT_MAX + 2; i++)
+    dare_context_push_int("level", i);
+  Exception e = new_exception("Deep", 3, NULL);
+  for (int i = 0; i < DARE_CONTEXT_MAX + 2; i++)
+    dare_context_pop();
+  cester_assert_equal(DARE_CONTEXT_MAX, dare_context_count(e));
+  cester_assert_llong_eq(DARE_CONTEXT_MAX - 1,
+                         dare_context_at(e, DARE_CONTEXT_MAX - 1)->value);
+  cester_assert_equal(0, dare_context.depth);
+  cancel(e);
+)
+
+CESTER_TEST(context_after_jump, ti,
+  try_jmp (
+    deep(2);
+  ) catch_jmp (
+    cester_assert_equal(3, dare_context_count(EVAR));
+    cester_assert_llong_eq(0, dare_context_at(EVAR, 2)->value);
+    cancel(EVAR);
+  )
+  cester_assert_equal(0, dare_context.depth);
+)
+
+CESTER_TEST(context_stacktrace, ti,
+  char *expected = ""
+  "Exception: (30) Not found\n"
+  "  in request=7 op=load\n"
+  "  at context_test.c:8\n";
+  Exception e = serve(7, "y");
+  CESTER_CAPTURE_STDOUT();
+  print_stacktrace(e);
+  cester_assert_stdout_stream_content_equal(expected);
+  CESTER_RELEASE_STDOUT();
+  cancel(e);
+)
+
+CESTER_TEST(context_same_line, ti,
+  {
+    with_context("a", "x"); with_context_int("b", 2);
+    cester_assert_equal(2, dare_context.depth);
+    with_deadline(1000000000); with_deadline(2000000000);
+  }
+  cester_assert_equal(0, dare_context.depth);
+  cester_assert_equal(INT64_MAX, dare_deadline.at);
+)
+
+CESTER_TEST(context_pop_empty, ti,
+  dare_context_pop();
+  cester_assert_equal(0, dare_context.depth);
+)
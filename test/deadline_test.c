@@ -0,0 +1,103 @@
+#define _POSIX_C_SOURCE 200809L
+#include "cester.h"
+#include "dare.h"
+#include <time.h>
+
+CESTER_BODY(
+  static void sleep_ms(long ms) {
+    struct timespec t = { 0, ms * 1000000 };
+    nanosleep(&t, NULL);
+  }
+
+  static Exception step(long ms) {
+    try (
+      sleep_ms(ms);
+      check_deadline()
+    ) catch (
+      return EVAR;
+    )
+    return SUCCESS;
+  }
+
+  static void jump(void) {
+    with_deadline(1000000);
+    throw_jmp("Jumped", 40);
+  }
+)
+
+CESTER_TEST(deadline_none, ti,
+  cester_assert_equal(INT64_MAX, dare_deadline_left());
+  Exception e = step(0);
+  cester_assert_null(e);
+)
+
+CESTER_TEST(deadline_not_expired, ti,
+  with_deadline(10000000000);
+  cester_assert_null(step(0));
+  int64_t left = dare_deadline_left();
+  cester_assert_true(left > 0 && left <= 10000000000);
+)
+
+CESTER_TEST(deadline_expired, ti,
+  with_deadline(2000000);
+  Exception e = step(50);
+  cester_assert_not_null(e);
+  cester_assert_equal(DARE_TIMEOUT_EXCEPTION, get_code(e));
+  cester_assert_str_equal(DARE_TIMEOUT_MSG, get_msg(e));
+  int64_t elapsed, budget;
+  cester_assert_equal(0, dare_get_int(e, "elapsed", &elapsed));
+  cester_assert_equal(0, dare_get_int(e, "budget", &budget));
+  cester_assert_equal(2000000, budget);
+  cester_assert_true(elapsed >= budget);
+  cester_assert_equal(0, dare_deadline_left());
+  cancel(e);
+)
+
+CESTER_TEST(deadline_nested, ti,
+  with_deadline(10000000000);
+  int64_t outer = dare_deadline.at;
+  {
+    with_deadline(20000000000);
+    cester_assert_equal(outer, dare_deadline.at);
+  }
+  {
+    with_deadline(1000000);
+    cester_assert_true(dare_deadline.at < outer);
+    cester_assert_equal(1000000, dare_deadline.budget);
+  }
+  cester_assert_equal(outer, dare_deadline.at);
+)
+
+CESTER_TEST(deadline_restored, ti,
+  {
+    with_deadline(1000000);
+  }
+  cester_assert_equal(INT64_MAX, dare_deadline.at);
+  cester_assert_equal(INT64_MAX, dare_deadline_left());
+)
+
+CESTER_TEST(deadline_jmp, ti,
+  try_jmp (
+    jump();
+  ) catch_jmp (
+    cester_assert_equal(40, get_code(EVAR));
+    cancel(EVAR);
+  )
+  cester_assert_equal(INT64_MAX, dare_deadline.at);
+)
+
+CESTER_TEST(deadline_stacktrace, ti,
+  Exception e;
+  {
+    with_deadline(0);
+    e = step(0);
+  }
+  CESTER_CAPTURE_STDOUT();
+  print_stacktrace(e);
+  cester_assert_stdout_stream_content_contain(
+    "Exception: (-1004) Deadline exceeded\n  with elapsed=");
+  cester_assert_stdout_stream_content_contain(
+    " budget=0\n  at deadline_test.c:15\n");
+  CESTER_RELEASE_STDOUT();
+  cancel(e);
+)
@@ -0,0 +1,105 @@
+#include "cester.h"
+#include "dare.h"
+#include <unistd.h>
+
+CESTER_BODY(
+  static Exception close_fd(int fd) {
+    try (
+      check_errno(close(fd));
+    ) catch (
+      return EVAR;
+    )
+    return SUCCESS;
+  }
+
+  static long submit(long result) {
+    return result;
+  }
+
+  static Exception wait_for(long result) {
+    try (
+      check_rc(submit(result));
+    ) catch (
+      return EVAR;
+    )
+    return SUCCESS;
+  }
+)
+
+CESTER_TEST(errno_success, ti,
+  int fds[2];
+  long n = 0;
+  FILE *fp = NULL;
+  try (
+    check_errno(pipe(fds));
+    check_errno(close(fds[0]));
+    check_rc(n = submit(3));
+    check_ptr(fp = fdopen(fds[1], "w"));
+  ) catch (
+    cester_assert_null(EVAR);
+    cancel(EVAR);
+  )
+  cester_assert_equal(3, n);
+  cester_assert_not_null(fp);
+  fclose(fp);
+)
+
+CESTER_TEST(errno_failure, ti,
+  Exception e = close_fd(-1);
+  cester_assert_equal(DARE_ERRNO_EXCEPTION, get_code(e));
+  cester_assert_equal(EBADF, get_errno(e));
+  cester_assert_str_equal("close(fd): Bad file descriptor", get_msg(e));
+  cancel(e);
+)
+
+CESTER_TEST(errno_rc, ti,
+  try (
+    check_rc(submit(-EAGAIN));
+  ) catch (
+    cester_assert_equal(EAGAIN, get_errno(EVAR));
+    cester_assert_str_equal("submit(-EAGAIN): Resource temporarily unavailable",
+                            get_msg(EVAR));
+    cancel(EVAR);
+  )
+)
+
+CESTER_TEST(errno_ptr, ti,
+  try (
+    check_ptr(fopen("/nonexistent/directory/with/a/long/name", "r"));
+  ) catch (
+    cester_assert_equal(ENOENT, get_errno(EVAR));
+    cester_assert_str_equal("fopen(\"/nonexistent/directory/with/a/long/name\", "
+                            "\"r\"): No such file or directory", get_msg(EVAR));
+    cancel(EVAR);
+  )
+)
+
+CESTER_TEST(errno_no_value, ti,
+  Exception e = new_exception("Plain", 1, NULL);
+  cester_assert_equal(0, get_errno(e));
+  cester_assert_equal(0, get_errno(NULL));
+  cancel(e);
+)
+
+CESTER_TEST(errno_fingerprint, ti,
+  Exception a = wait_for(-EBADF);
+  Exception b = wait_for(-EBADF);
+  Exception c = wait_for(-EAGAIN);
+  cester_assert_true(same_fingerprint(a, b));
+  cester_assert_false(same_fingerprint(a, c));
+  cancel(a);
+  cancel(b);
+  cancel(c);
+)
+
+CESTER_TEST(errno_stacktrace, ti,
+  char *expected = ""
+  "Exception: (-1003) close(fd): Bad file descriptor\n"
+  "  at errno_test.c:8\n";
+  Exception e = close_fd(-2);
+  CESTER_CAPTURE_STDOUT();
+  print_stacktrace(e);
+  cester_assert_stdout_stream_content_equal(expected);
+  CESTER_RELEASE_STDOUT();
+  cancel(e);
+)
@@ -0,0 +1,96 @@
+#include "cester.h"
+#include "dare.h"
+
+CESTER_BODY(
+  static Exception read_block(long offset) {
+    try (
+      throw("Short read", 20);
+    ) catch (
+      dare_set_int(EVAR, "offset", offset);
+      dare_set_str(EVAR, "shard", "eu-west-1");
+      return EVAR;
+    )
+  }
+)
+
+CESTER_TEST(typed_fields, ti,
+  Exception e = new_exception("Fields", 1, NULL);
+  int64_t i = 0;
+  double d = 0;
+  char const *s = NULL;
+  void const *p = NULL;
+  cester_assert_equal(0, dare_set_int(e, "request", -42));
+  cester_assert_equal(0, dare_set_double(e, "ratio", 0.5));
+  cester_assert_equal(0, dare_set_str(e, "user", "alice"));
+  cester_assert_equal(0, dare_set_ptr(e, "buffer", &i));
+  cester_assert_equal(0, dare_get_int(e, "request", &i));
+  cester_assert_equal(0, dare_get_double(e, "ratio", &d));
+  cester_assert_equal(0, dare_get_str(e, "user", &s));
+  cester_assert_equal(0, dare_get_ptr(e, "buffer", &p));
+  cester_assert_llong_eq(-42, i);
+  cester_assert_double_eq(0.5, d);
+  cester_assert_str_equal("alice", s);
+  cester_assert_ptr_equal(&i, (void *) p);
+  cancel(e);
+)
+
+CESTER_TEST(missing_fields, ti,
+  Exception e = new_exception("Fields", 2, NULL);
+  int64_t i = 7;
+  char key[] = "request";
+  cester_assert_equal(-1, dare_get_int(e, "request", &i));
+  dare_set_double(e, "request", 1.0);
+  cester_assert_equal(-1, dare_get_int(e, "request", &i));
+  dare_set_int(e, key, 3);
+  cester_assert_equal(1, dare_field_count(e));
+  cester_assert_equal(0, dare_get_int(e, "request", &i));
+  cester_assert_llong_eq(3, i);
+  cester_assert_equal(-1, dare_set_int(NULL, "request", 1));
+  cester_assert_equal(-1, dare_get_int(NULL, "request", &i));
+  cancel(e);
+)
+
+CESTER_TEST(full_fields, ti,
+  Exception e = new_exception("Fields", 3, NULL);
+  char const *keys[] = { "a", "b", "c", "d", "e", "f", "g", "h" };
+  char const *key = NULL;
+  for (int i = 0; i < DARE_FIELDS; i++)
+    cester_assert_equal(0, dare_set_int(e, keys[i], i));
+  cester_assert_equal(-1, dare_set_int(e, keys[DARE_FIELDS], 0));
+  cester_assert_equal(DARE_FIELDS, dare_field_count(e));
+  cester_assert_equal(DARE_FIELD_INT, dare_field_at(e, 1, &key));
+  cester_assert_str_equal("b", key);
+  cester_assert_equal(-1, dare_field_at(e, DARE_FIELDS, &key));
+  cancel(e);
+)
+
+CESTER_TEST(truncated_string, ti,
+  Exception e = new_exception("Fields", 4, NULL);
+  char const *s = NULL;
+  dare_set_str(e, "path", "/a/very/long/path/to/a/file");
+  dare_get_str(e, "path", &s);
+  cester_assert_equal(DARE_FIELD_STR_SIZE - 1, strlen(s));
+  cancel(e);
+)
+
+CESTER_TEST(reused_slot_has_no_fields, ti,
+  Exception e = new_exception("Fields", 5, NULL);
+  dare_set_int(e, "stale", 1);
+  cancel(e);
+  e = new_exception("Fields", 6, NULL);
+  cester_assert_equal(0, dare_field_count(e));
+  cancel(e);
+)
+
+CESTER_TEST(stacktrace_fields, ti,
+  char *expected = ""
+  "Exception: (20) Short read\n"
+  "  with offset=4096 shard=\"eu-west-1\"\n"
+  "  at field_test.c:7\n";
+  Exception e = read_block(4096);
+  CESTER_CAPTURE_STDOUT();
+  print_stacktrace(e);
+  cester_assert_stdout_stream_content_equal(expected);
+  CESTER_RELEASE_STDOUT();
+  cancel(e);
+)
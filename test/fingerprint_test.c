@@ -0,0 +1,84 @@
+#include "cester.h"
+#include "dare.h"
+
+CESTER_BODY(
+  static Exception fail(int which, int value) {
+    try (
+      if (which == 0) throwf(40, "Bad value %d", value);
+      if (which == 1) throw("Other site", 40);
+      if (which == 2) throw("Other code", 41);
+    ) catch (
+      return EVAR;
+    )
+    return SUCCESS;
+  }
+
+  static Exception wrap(int which, int value) {
+    try (
+      check_cause(fail(which, value), "Wrapped", 42);
+    ) catch (
+      return EVAR;
+    )
+    return SUCCESS;
+  }
+
+  static void cancel_chain(Exception e) {
+    while (e) {
+      Exception cause = get_cause(e);
+      cancel(e);
+      e = cause;
+    }
+  }
+)
+
+CESTER_TEST(same_site_same_fingerprint, ti,
+  Exception a = fail(0, 1);
+  Exception b = fail(0, 2);
+  cester_assert_not_equal(0, get_fingerprint(a));
+  cester_assert_true(same_fingerprint(a, b));
+  cester_assert_true(same_error(a, b));
+  cancel(a);
+  cancel(b);
+)
+
+CESTER_TEST(different_sites, ti,
+  Exception a = fail(0, 1);
+  Exception b = fail(1, 1);
+  Exception c = fail(2, 1);
+  cester_assert_false(same_fingerprint(a, b));
+  cester_assert_false(same_fingerprint(b, c));
+  cester_assert_false(same_error(a, b));
+  cester_assert_false(same_error(a, NULL));
+  cester_assert_equal(0, get_fingerprint(NULL));
+  cancel(a);
+  cancel(b);
+  cancel(c);
+)
+
+CESTER_TEST(chain_fingerprint, ti,
+  Exception a = wrap(0, 1);
+  Exception b = wrap(0, 2);
+  Exception c = wrap(1, 1);
+  cester_assert_true(same_error(a, b));
+  cester_assert_false(same_fingerprint(a, c));
+  cester_assert_false(same_fingerprint(a, get_cause(a)));
+  cancel_chain(a);
+  cancel_chain(b);
+  cancel_chain(c);
+)
+
+CESTER_TEST(lines_change_fingerprint, ti,
+  Exception a = new_exception("Lines", 43, NULL);
+  Exception b = new_exception("Lines", 43, NULL);
+  cester_assert_true(same_error(a, b));
+  add_line(a, "  at x.c:1");
+  cester_assert_false(same_fingerprint(a, b));
+  add_line(b, "  at x.c:1");
+  cester_assert_true(same_error(a, b));
+  uint64_t before = get_fingerprint(a);
+  a = compact(a);
+  cester_assert_llong_eq(before, get_fingerprint(a));
+  cester_assert_true(same_error(a, b));
+  cancel(a);
+  cancel(b);
+)
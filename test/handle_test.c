@@ -0,0 +1,48 @@
+#include "cester.h"
+#include "dare.h"
+
+CESTER_TEST(handle_round_trip, ti,
+  Exception e = new_exception("Pooled", 90, NULL);
+  ExceptionHandle h = get_handle(e);
+  cester_assert_not_equal(NULL_HANDLE, h);
+  cester_assert_ptr_equal(e, from_handle(h));
+  cester_assert_equal(90, get_code(from_handle(h)));
+  cancel_handle(h);
+  cester_assert_null(from_handle(h));
+)
+
+CESTER_TEST(stale_handle, ti,
+  Exception e = new_exception("First", 1, NULL);
+  ExceptionHandle old = get_handle(e);
+  cancel(e);
+  Exception reused = new_exception("Second", 2, NULL);
+  ExceptionHandle h = get_handle(reused);
+  cester_assert_ptr_equal(e, reused);
+  cester_assert_not_equal(old, h);
+  cester_assert_null(from_handle(old));
+  cancel_handle(old);
+  cester_assert_equal(2, get_code(from_handle(h)));
+  cancel(reused);
+)
+
+CESTER_TEST(double_cancel, ti,
+  Exception e = add_line(new_exception("Twice", 3, NULL), "  at here");
+  cancel(e);
+  cancel(e);
+  Exception a = new_exception("A", 4, NULL);
+  Exception b = new_exception("B", 5, NULL);
+  cester_assert_ptr_not_equal(a, b);
+  cancel(a);
+  cancel(b);
+)
+
+CESTER_TEST(pool_exhaustion, ti,
+  Exception all[DARE_SLOTS + 1];
+  for (int i = 0; i <= DARE_SLOTS; i++)
+    all[i] = new_exception("Many", i, NULL);
+  cester_assert_equal(NULL_HANDLE, get_handle(all[DARE_SLOTS]));
+  for (int i = 0; i <= DARE_SLOTS; i++) {
+    cester_assert_equal(i, get_code(all[i]));
+    cancel(all[i]);
+  }
+)
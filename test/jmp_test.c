@@ -0,0 +1,81 @@
+#include "cester.h"
+#include "dare.h"
+
+CESTER_BODY(
+  int cleaned = 0;
+
+  void count_cleanup(void *arg) {
+    cleaned += *(int *) arg;
+  }
+
+  int descend(int depth) {
+    if (depth == 0) throw_jmp("Bottom reached", 80);
+    int one = 1;
+    int result = 0;
+    cleanup_jmp(count_cleanup, &one,
+      result = descend(depth - 1) + 1;
+    )
+    return result;
+  }
+
+  Exception throw_directly() {
+    try (
+      throw("Thrown directly", 10);
+      return SUCCESS;
+    ) catch (
+      return EVAR;
+    )
+  }
+)
+
+CESTER_TEST(throw_from_depth, ti,
+  volatile int fail = 0;
+  cleaned = 0;
+  try_jmp (
+    descend(30);
+    fail = 1;
+  ) catch_jmp (
+    cester_assert_equal(80, get_code(EVAR));
+    cester_assert_str_equal("Bottom reached", get_msg(EVAR));
+    cancel(EVAR);
+  )
+  cester_assert_false(fail);
+  cester_assert_equal(30, cleaned);
+  cester_assert_null(dare_handler_top);
+  cester_assert_null(dare_cleanup_top);
+)
+
+CESTER_TEST(dont_throw_jmp, ti,
+  volatile int fail = 1;
+  int two = 2;
+  cleaned = 0;
+  try_jmp (
+    cleanup_jmp(count_cleanup, &two,
+      fail = 0;
+    )
+  ) catch_jmp (
+    fail = 1;
+  )
+  cester_assert_false(fail);
+  cester_assert_equal(2, cleaned);
+  cester_assert_null(dare_handler_top);
+)
+
+CESTER_TEST(nested_handlers, ti,
+  volatile int inner = 0;
+  volatile int outer = 0;
+  try_jmp (
+    try_jmp (
+      check_jmp(throw_directly());
+    ) catch_jmp (
+      inner = get_code(EVAR);
+      rethrow_jmp(EVAR);
+    )
+  ) catch_jmp (
+    outer = get_code(EVAR);
+    cancel(EVAR);
+  )
+  cester_assert_equal(10, inner);
+  cester_assert_equal(10, outer);
+  cester_assert_null(dare_handler_top);
+)
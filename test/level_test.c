@@ -0,0 +1,59 @@
+#include "cester.h"
+#include "dare.h"
+
+// cester includes this file more than once, so the level is reset here
+#undef DARE_ASSERT_LEVEL
+#define DARE_ASSERT_LEVEL DARE_ASSERT_CRITICAL
+
+CESTER_BODY(
+  int evaluations = 0;
+
+  int evaluate(int x) {
+    evaluations++;
+    return x;
+  }
+)
+
+CESTER_TEST(stripped_assertion, ti,
+  evaluations = 0;
+  try (
+    assert_true(evaluate(0), "Should not happen", 0);
+    assert_equal_at(DARE_ASSERT_PARANOID, evaluate(1), 2, "Should not happen", 0);
+  ) catch (
+    cester_assert_null(EVAR);
+    cancel(EVAR);
+  )
+  cester_assert_equal(0, evaluations);
+)
+
+CESTER_TEST(critical_assertion, ti,
+  evaluations = 0;
+  int fail = 0;
+  try (
+    assert_equal_at(DARE_ASSERT_CRITICAL, evaluate(1), 2, "Should happen", 40);
+    fail = 1;
+  ) catch (
+    cester_assert_equal(40, get_code(EVAR));
+    cancel(EVAR);
+  )
+  cester_assert_false(fail);
+  cester_assert_equal(1, evaluations);
+)
+
+#undef DARE_ASSERT_LEVEL
+#define DARE_ASSERT_LEVEL DARE_ASSERT_PARANOID
+
+CESTER_TEST(paranoid_assertion, ti,
+  evaluations = 0;
+  int fail = 0;
+  try (
+    assert_true(evaluate(1), "Should not happen", 0);
+    assert_lt_at(DARE_ASSERT_PARANOID, evaluate(2), 1, "Should happen", 50);
+    fail = 1;
+  ) catch (
+    cester_assert_equal(50, get_code(EVAR));
+    cancel(EVAR);
+  )
+  cester_assert_false(fail);
+  cester_assert_equal(2, evaluations);
+)
@@ -0,0 +1,139 @@
+#include "cester.h"
+#include "dare.h"
+
+CESTER_BODY(
+  static Exception open_file(char const *path, int fd) {
+    try (
+      if (fd < 0) throwf(7, "Cannot open %s (fd %d)", path, fd);
+    ) catch (
+      return EVAR;
+    )
+    return SUCCESS;
+  }
+
+  static Exception read_config(char const *path) {
+    try (
+      check_causef(open_file(path, -1), 8, "No config at %s", path);
+    ) catch (
+      return EVAR;
+    )
+    return SUCCESS;
+  }
+)
+
+CESTER_TEST(owned_copy, ti,
+  char buffer[] = "Temporary";
+  Exception e = new_exception_owned(buffer, 1, NULL);
+  buffer[0] = 'X';
+  cester_assert_str_equal("Temporary", get_msg(e));
+  cancel(e);
+)
+
+CESTER_TEST(short_message_inline, ti,
+  Exception e = open_file("a.txt", -2);
+  cester_assert_str_equal("Cannot open a.txt (fd -2)", get_msg(e));
+  cester_assert_equal(7, get_code(e));
+  cancel(e);
+)
+
+CESTER_TEST(long_message_heap, ti,
+  char path[200];
+  memset(path, 'p', sizeof path - 1);
+  path[sizeof path - 1] = '\0';
+  Exception e = open_file(path, -1);
+  cester_assert_equal(strlen("Cannot open  (fd -1)") + strlen(path),
+                      strlen(get_msg(e)));
+  cester_assert_equal(0, strncmp(path, get_msg(e) + 12, strlen(path)));
+  cancel(e);
+)
+
+CESTER_TEST(formatted_cause, ti,
+  Exception e = read_config("b.conf");
+  cester_assert_str_equal("No config at b.conf", get_msg(e));
+  cester_assert_str_equal("Cannot open b.conf (fd -1)",
+                          get_msg(get_cause(e)));
+  cancel(get_cause(e));
+  cancel(e);
+)
+
+CESTER_TEST(formatted_jmp, ti,
+  int value = 41;
+  try_jmp (
+    throwf_jmp(9, "Value %d", value + 1);
+  ) catch_jmp (
+    cester_assert_str_equal("Value 42", get_msg(EVAR));
+    cancel(EVAR);
+  )
+)
+
+CESTER_BODY(
+  static Exception lazy_types(unsigned char byte, size_t size, double real) {
+    try (
+      throwf_lazy(10, "%d %hhu %zu [%5.2f] %c", -3, byte, size, real, 'x');
+    ) catch (
+      return EVAR;
+    )
+    return SUCCESS;
+  }
+
+  static Exception lazy_cause(char const *name, int *value) {
+    try (
+      check_causef_lazy(lazy_types(1, 2, 3), 11, "%s=%d at %p %%%-4s|",
+                        name, *value, (void *) value, "ok");
+    ) catch (
+      return EVAR;
+    )
+    return SUCCESS;
+  }
+)
+
+CESTER_TEST(lazy_types, ti,
+  Exception e = lazy_types(200, 123456789012u, 2.5);
+  cester_assert_equal(10, get_code(e));
+  cester_assert_str_equal("-3 200 123456789012 [ 2.50] x", get_msg(e));
+  cancel(e);
+)
+
+CESTER_TEST(lazy_rendered_when_read, ti,
+  char name[] = "before";
+  int value = 5;
+  char expected[64];
+  Exception e = lazy_cause(name, &value);
+  memcpy(name, "after", sizeof "after");
+  snprintf(expected, sizeof expected, "after=5 at %p %%ok  |", (void *) &value);
+  cester_assert_str_equal(expected, get_msg(e));
+  cester_assert_ptr_equal((void *) get_msg(e), (void *) get_msg(e));
+  cester_assert_str_equal("-3 1 2 [ 3.00] x", get_msg(get_cause(e)));
+  cancel(get_cause(e));
+  cancel(e);
+)
+
+CESTER_TEST(lazy_long_message, ti,
+  char path[100];
+  memset(path, 'q', sizeof path - 1);
+  path[sizeof path - 1] = '\0';
+  try (
+    throwf_lazy(12, "Cannot read %s", path);
+  ) catch (
+    cester_assert_equal(strlen("Cannot read ") + strlen(path),
+                        strlen(get_msg(EVAR)));
+    cancel(EVAR);
+  )
+)
+
+CESTER_TEST(lazy_stacktrace, ti,
+  char *expected = ""
+  "Exception: (13) Value 7 of 8\n";
+  CESTER_CAPTURE_STDOUT();
+  try_jmp (
+    throwf_lazy_jmp(13, "Value %d of %d", 7, 8);
+  ) catch_jmp (
+    Exception e = new_exception_lazy(13, NULL, "Value %d of %d", 2,
+      (struct dare_arg const []) { dare_arg(7), dare_arg(8) });
+    print_stacktrace(e);
+    cancel(e);
+    cancel(EVAR);
+  )
+  cester_assert_stdout_stream_content_equal(expected);
+  CESTER_RELEASE_STDOUT();
+)
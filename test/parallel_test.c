@@ -0,0 +1,112 @@
+#include "cester.h"
+#include "dare.h"
+#include <stdatomic.h>
+
+CESTER_BODY(
+  #define N 10007
+
+  _Atomic int visits[N];
+
+  static Exception visit(size_t begin, size_t end, void *arg) {
+    (void) arg;
+    for (size_t i = begin; i < end; i++) visits[i]++;
+    return SUCCESS;
+  }
+
+  static Exception fail_at(size_t begin, size_t end, void *arg) {
+    size_t bad = *(size_t *) arg;
+    for (size_t i = begin; i < end && !dare_cancelled(); i++) {
+      visits[i]++;
+      if (i == bad) return new_exception("Bad item", 50, NULL);
+    }
+    return SUCCESS;
+  }
+
+  static Exception fail_even(size_t begin, size_t end, void *arg) {
+    (void) end;
+    (void) arg;
+    if (begin / 100 % 2 == 0) return new_exception("Even chunk", 51, NULL);
+    return SUCCESS;
+  }
+
+  static Exception nested(size_t begin, size_t end, void *arg) {
+    for (size_t i = begin; i < end; i++) {
+      Exception e = dare_parallel_for(arg, DARE_RANGE(i * 10, i * 10 + 10, 3),
+                                      visit, NULL);
+      if (e) return e;
+    }
+    return SUCCESS;
+  }
+
+  static int visited_once(size_t n) {
+    for (size_t i = 0; i < n; i++)
+      if (visits[i] != 1) return 0;
+    return 1;
+  }
+)
+
+CESTER_TEST(parallel_every_iteration, ti,
+  struct dare_pool *pool = dare_pool_new(4);
+  size_t grains[] = { 0, 1, 7, 1000, 20000 };
+  for (size_t g = 0; g < sizeof grains / sizeof *grains; g++) {
+    memset(visits, 0, sizeof visits);
+    cester_assert_null(dare_parallel_for(pool, DARE_RANGE(0, N, grains[g]),
+                                         visit, NULL));
+    cester_assert_true(visited_once(N));
+  }
+  dare_pool_free(pool);
+)
+
+CESTER_TEST(parallel_first_failure, ti,
+  struct dare_pool *pool = dare_pool_new(4);
+  size_t bad = 5000;
+  int64_t worker, chunk;
+  memset(visits, 0, sizeof visits);
+  Exception e = dare_parallel_for(pool, DARE_RANGE(0, N, 10), fail_at, &bad);
+  cester_assert_equal(50, get_code(e));
+  cester_assert_equal(0, dare_get_int(e, "chunk", &chunk));
+  cester_assert_equal(500, chunk);
+  cester_assert_equal(0, dare_get_int(e, "worker", &worker));
+  cester_assert_true(worker >= 0 && worker < 4);
+  cester_assert_equal(1, visits[bad]);
+  cester_assert_false(dare_cancelled());
+  cancel(e);
+  dare_pool_free(pool);
+)
+
+CESTER_TEST(parallel_all_failures, ti,
+  struct dare_pool *pool = dare_pool_new(3);
+  struct dare_range range = DARE_RANGE(0, 1000, 100);
+  range.failures = DARE_ALL_FAILURES;
+  Exception e = dare_parallel_for(pool, range, fail_even, NULL);
+  cester_assert_equal(DARE_AGGREGATE_EXCEPTION, get_code(e));
+  cester_assert_equal(5, get_child_count(e));
+  for (size_t i = 0; i < get_child_count(e); i++) {
+    int64_t index;
+    cester_assert_equal(0, dare_get_int(get_child(e, i), "index", &index));
+    cester_assert_equal(0, index % 2);
+  }
+  cancel(e);
+  dare_pool_free(pool);
+)
+
+CESTER_TEST(parallel_nested, ti,
+  struct dare_pool *pool = dare_pool_new(4);
+  memset(visits, 0, sizeof visits);
+  cester_assert_null(dare_parallel_for(pool, DARE_RANGE(0, N / 10, 0),
+                                       nested, pool));
+  cester_assert_true(visited_once(N / 10 * 10));
+  dare_pool_free(pool);
+)
+
+CESTER_TEST(parallel_shared_pool, ti,
+  memset(visits, 0, sizeof visits);
+  cester_assert_null(dare_parallel_for(NULL, DARE_RANGE(0, N, 0), visit, NULL));
+  cester_assert_true(visited_once(N));
+  memset(visits, 0, sizeof visits);
+  struct dare_pool *pool = dare_pool_new(1);
+  cester_assert_null(dare_parallel_for(pool, DARE_RANGE(5, N, 0), visit, NULL));
+  cester_assert_equal(0, visits[4]);
+  cester_assert_equal(1, visits[N - 1]);
+  dare_pool_free(pool);
+)
@@ -0,0 +1,110 @@
+#define _POSIX_C_SOURCE 200809L
+#include "cester.h"
+#include "dare.h"
+#include <pthread.h>
+
+CESTER_BODY(
+  #define PRODUCERS 4
+  #define PER_PRODUCER 20000
+
+  struct dare_queue queue;
+
+  static void *produce(void *arg) {
+    int producer = (int) (intptr_t) arg;
+    for (int i = 0; i < PER_PRODUCER; i++) {
+      Exception e = new_exception("Produced", i, NULL);
+      dare_set_int(e, "producer", producer);
+      dare_queue_push(&queue, e);
+    }
+    return NULL;
+  }
+
+  static void *produce_late(void *arg) {
+    struct timespec pause = { 0, 20000000 };
+    nanosleep(&pause, NULL);
+    dare_queue_push(&queue, arg);
+    return NULL;
+  }
+)
+
+CESTER_TEST(queue_order, ti,
+  Exception out[4];
+  cester_assert_equal(0, dare_queue_init(&queue));
+  for (int i = 0; i < 10; i++)
+    dare_queue_push(&queue, new_exception("Pushed", i, NULL));
+  int next = 0;
+  size_t count;
+  while ((count = dare_queue_pop(&queue, out, 4))) {
+    cester_assert_true(count <= 4);
+    for (size_t i = 0; i < count; i++) {
+      cester_assert_equal(next++, get_code(out[i]));
+      cancel(out[i]);
+    }
+  }
+  cester_assert_equal(10, next);
+  dare_queue_destroy(&queue);
+)
+
+CESTER_TEST(queue_producers, ti,
+  pthread_t threads[PRODUCERS];
+  int next[PRODUCERS] = { 0 };
+  int total = 0;
+  Exception out[64];
+  cester_assert_equal(0, dare_queue_init(&queue));
+  for (int i = 0; i < PRODUCERS; i++)
+    pthread_create(&threads[i], NULL, produce, (void *) (intptr_t) i);
+  while (total < PRODUCERS * PER_PRODUCER) {
+    size_t count = dare_queue_wait(&queue, out, 64, 1000);
+    cester_assert_true(count > 0);
+    if (!count) break;
+    for (size_t i = 0; i < count; i++) {
+      int64_t producer;
+      dare_get_int(out[i], "producer", &producer);
+      if (get_code(out[i]) != next[producer]++) total = -1000000;
+      cancel(out[i]);
+    }
+    total += count;
+  }
+  for (int i = 0; i < PRODUCERS; i++) pthread_join(threads[i], NULL);
+  cester_assert_equal(PRODUCERS * PER_PRODUCER, total);
+  dare_queue_destroy(&queue);
+)
+
+CESTER_TEST(queue_wakeup, ti,
+  pthread_t thread;
+  Exception out[2];
+  cester_assert_equal(0, dare_queue_init(&queue));
+  cester_assert_equal(0, dare_queue_wait(&queue, out, 2, 10));
+  pthread_create(&thread, NULL, produce_late, new_exception("Late", 40, NULL));
+  cester_assert_equal(1, dare_queue_wait(&queue, out, 2, -1));
+  cester_assert_equal(40, get_code(out[0]));
+  cancel(out[0]);
+  pthread_join(thread, NULL);
+  dare_queue_destroy(&queue);
+)
+
+CESTER_TEST(queue_destroy, ti,
+  cester_assert_equal(0, dare_queue_init(&queue));
+  Exception e = new_exception("Left", 41, NULL);
+  ExceptionHandle h = get_handle(e);
+  dare_queue_push(&queue, e);
+  dare_queue_destroy(&queue);
+  cester_assert_null(from_handle(h));
+)
+
+CESTER_TEST(queue_refuses_frozen, ti,
+  Exception out[2];
+  cester_assert_equal(0, dare_queue_init(&queue));
+  Exception e = dare_retain(new_exception("Shared", 42, NULL));
+  cester_assert_equal(-1, dare_queue_push(&queue, e));
+  cester_assert_equal(-1, dare_queue_push(&queue, e));
+  cester_assert_equal(-1, dare_queue_push(&queue, NULL));
+  cester_assert_equal(0, dare_queue_pop(&queue, out, 2));
+  cester_assert_equal(0, dare_queue_push(&queue, new_exception("Own", 43, NULL)));
+  cester_assert_equal(1, dare_queue_pop(&queue, out, 2));
+  cester_assert_equal(43, get_code(out[0]));
+  cancel(out[0]);
+  dare_release(e);
+  dare_release(e);
+  dare_queue_destroy(&queue);
+)
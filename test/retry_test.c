@@ -0,0 +1,108 @@
+#define _POSIX_C_SOURCE 200809L
+#include "cester.h"
+#include "dare.h"
+#include <time.h>
+
+CESTER_BODY(
+  static int calls;
+
+  static Exception flaky(int failures, int transient) {
+    calls++;
+    try (
+      if (calls <= failures) {
+        if (transient) throw_transient("Busy", 50, 0);
+        throw("Broken", 51);
+      }
+    ) catch (
+      return EVAR;
+    )
+    return SUCCESS;
+  }
+
+  static Exception retried(int failures, int transient, int attempts) {
+    calls = 0;
+    try (
+      check_retry(flaky(failures, transient), DARE_RETRY(attempts, 100000, 400000));
+    ) catch (
+      return EVAR;
+    )
+    return SUCCESS;
+  }
+
+  static double seconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+  }
+
+  static ExceptionHandle causes[4];
+
+  static Exception flaky_chain(void) {
+    Exception cause = new_exception("Socket", 53, NULL);
+    causes[calls++] = get_handle(cause);
+    if (calls < 4)
+      return set_transient(new_exception("Busy", 52, cause), 0);
+    cancel(cause);
+    return SUCCESS;
+  }
+)
+
+CESTER_TEST(retry_until_success, ti,
+  cester_assert_null(retried(3, 1, 5));
+  cester_assert_equal(4, calls);
+)
+
+CESTER_TEST(retry_gives_up, ti,
+  Exception e = retried(10, 1, 3);
+  cester_assert_equal(3, calls);
+  cester_assert_equal(50, get_code(e));
+  cester_assert_equal(3, get_attempts(e));
+  cester_assert_true(is_transient(e));
+  cancel(e);
+)
+
+CESTER_TEST(permanent_not_retried, ti,
+  Exception e = retried(10, 0, 5);
+  cester_assert_equal(1, calls);
+  cester_assert_equal(1, get_attempts(e));
+  cester_assert_false(is_transient(e));
+  cancel(e);
+)
+
+CESTER_TEST(retry_after_respected, ti,
+  double start = seconds();
+  Exception e = NULL;
+  calls = 0;
+  try (
+    check_retry(set_transient(new_exception("Later", 52, NULL), 20000000),
+                DARE_RETRY(2, 1000, 1000));
+  ) catch (
+    e = EVAR;
+  )
+  cester_assert_true(seconds() - start >= 0.02);
+  cester_assert_llong_eq(20000000, get_retry_after(e));
+  cester_assert_equal(2, get_attempts(e));
+  cancel(e);
+)
+
+CESTER_TEST(transient_accessors, ti,
+  Exception e = new_exception("Plain", 53, NULL);
+  cester_assert_false(is_transient(e));
+  cester_assert_ptr_equal(e, set_transient(e, -5));
+  cester_assert_true(is_transient(e));
+  cester_assert_llong_eq(0, get_retry_after(e));
+  cester_assert_equal(0, get_attempts(e));
+  cester_assert_null(set_transient(NULL, 0));
+  cancel(e);
+)
+
+CESTER_TEST(retry_releases_causes, ti,
+  calls = 0;
+  try (
+    check_retry(flaky_chain(), DARE_RETRY(5, 100000, 400000));
+  ) catch (
+    cester_assert_null(EVAR);
+  )
+  cester_assert_equal(4, calls);
+  for (int i = 0; i < 4; i++) cester_assert_null(from_handle(causes[i]));
+)
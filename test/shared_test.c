@@ -0,0 +1,127 @@
+#include "cester.h"
+#include "dare.h"
+#include <pthread.h>
+
+CESTER_BODY(
+  static Exception fail(int value) {
+    try (
+      throwf_lazy(20, "Failed with %d", value);
+    ) catch (
+      return EVAR;
+    )
+    return SUCCESS;
+  }
+
+  static void *consume(void *arg) {
+    Exception e = arg;
+    size_t length = 0;
+    for (int i = 0; i < 1000; i++)
+      length += strlen(get_msg(e)) + strlen(get_msg(get_cause(e)));
+    dare_release(e);
+    return (void *) length;
+  }
+)
+
+CESTER_TEST(shared_not_frozen, ti,
+  Exception e = fail(1);
+  cester_assert_false(is_frozen(e));
+  cester_assert_false(is_frozen(NULL));
+  dare_release(e);
+)
+
+CESTER_TEST(shared_release_once, ti,
+  Exception e = dare_retain(fail(2));
+  ExceptionHandle h = get_handle(e);
+  cester_assert_true(is_frozen(e));
+  dare_retain(e);
+  dare_release(e);
+  cester_assert_ptr_equal(e, from_handle(h));
+  cancel(e);
+  cester_assert_ptr_equal(e, from_handle(h));
+  dare_release(e);
+  cester_assert_null(from_handle(h));
+)
+
+CESTER_TEST(shared_chain, ti,
+  Exception cause = fail(3);
+  Exception e = new_exception("Wrapper", 21, cause);
+  ExceptionHandle hc = get_handle(cause);
+  dare_retain(e);
+  cester_assert_true(is_frozen(cause));
+  cester_assert_str_equal("Failed with 3", get_msg(cause));
+  dare_release(e);
+  cester_assert_ptr_equal(cause, from_handle(hc));
+  dare_release(e);
+  cester_assert_null(from_handle(hc));
+)
+
+CESTER_TEST(shared_immutable, ti,
+  Exception e = dare_retain(fail(4));
+  cester_assert_equal(-1, dare_set_int(e, "key", 1));
+  cester_assert_equal(0, dare_field_count(e));
+  cester_assert_ptr_equal(e, add_line(e, "  at nowhere"));
+  cester_assert_ptr_equal(e, set_transient(e, 10));
+  cester_assert_false(is_transient(e));
+  cester_assert_ptr_equal(e, compact(e));
+  dare_release(e);
+  dare_release(e);
+)
+
+CESTER_TEST(shared_in_aggregate, ti,
+  Exception all = new_aggregate("All", 22);
+  Exception e = dare_retain(fail(5));
+  cester_assert_equal(0, aggregate_add(all, e));
+  cester_assert_str_equal("Failed with 5", get_msg(get_child(all, 0)));
+  cester_assert_str_equal("Failed with 5", get_msg(e));
+  dare_release(e);
+  cancel(all);
+)
+
+CESTER_TEST(shared_threads, ti,
+  pthread_t threads[4];
+  Exception e = new_exception("Wrapper", 23, fail(6));
+  dare_retain(e);
+  for (int i = 1; i < 4; i++) dare_retain(e);
+  for (int i = 0; i < 4; i++)
+    pthread_create(&threads[i], NULL, consume, e);
+  dare_release(e);
+  for (int i = 0; i < 4; i++) {
+    void *length;
+    pthread_join(threads[i], &length);
+    cester_assert_equal(1000 * strlen("WrapperFailed with 6"), (size_t) length);
+  }
+)
+
+CESTER_TEST(shared_compacted_cause, ti,
+  Exception s = dare_retain(new_exception("s", 4, new_exception("t", 5, NULL)));
+  ExceptionHandle hs = get_handle(s);
+  Exception w = compact(new_exception("w", 6, s));
+  cester_assert_str_equal("t", get_msg(get_root_cause(w)));
+  cester_assert_ptr_equal(s, from_handle(hs));
+  Exception x = new_exception("x", 7, NULL);
+  dare_release(s);
+  cester_assert_null(from_handle(hs));
+  Exception y = new_exception("y", 8, NULL);
+  cester_assert_ptr_not_equal(x, y);
+  cester_assert_str_equal("x", get_msg(x));
+  cancel(x);
+  cancel(y);
+  cancel(w);
+)
+
+CESTER_TEST(shared_cancel_members, ti,
+  Exception e = dare_retain(new_exception("e", 9, fail(7)));
+  Exception c = get_cause(e);
+  ExceptionHandle he = get_handle(e), hc = get_handle(c);
+  cancel(c);
+  cester_assert_null(from_handle(hc));
+  Exception x = new_exception("x", 10, NULL);
+  ExceptionHandle hx = get_handle(x);
+  cancel(e);
+  cester_assert_ptr_equal(e, from_handle(he));
+  cancel(e);
+  cester_assert_null(from_handle(he));
+  cester_assert_ptr_equal(x, from_handle(hx));
+  cester_assert_str_equal("x", get_msg(x));
+  cancel(x);
+)
@@ -0,0 +1,104 @@
+#include "cester.h"
+#include "dare.h"
+#include <signal.h>
+
+// cester includes this file more than once, so the levels are reset here
+#undef DARE_ASSERT_LEVEL
+#define DARE_ASSERT_LEVEL DARE_ASSERT_PARANOID
+#undef DARE_ASSERT_ACTIVE_LEVEL
+#define DARE_ASSERT_ACTIVE_LEVEL DARE_ASSERT_NORMAL
+
+CESTER_BODY(
+  Exception guarded(int x) {
+    try (
+      assert_gt(x, 0, "Not positive", 60);
+      return SUCCESS;
+    ) catch (
+      return EVAR;
+    )
+  }
+
+  Exception dormant(int x) {
+    try (
+      assert_lt_at(DARE_ASSERT_PARANOID, x, 100, "Too large", 70);
+      return SUCCESS;
+    ) catch (
+      return EVAR;
+    )
+  }
+
+  int scans = 0;
+
+  double const *scanned(double const *values) {
+    scans++;
+    return values;
+  }
+
+  Exception scan(double const *values, size_t n) {
+    try (
+      assert_all_finite(scanned(values), n, "Not finite", 80);
+      return SUCCESS;
+    ) catch (
+      return EVAR;
+    )
+  }
+
+  int thrown(Exception e) {
+    int code = get_code(e);
+    cancel(e);
+    return code;
+  }
+)
+
+CESTER_TEST(disable_by_function, ti,
+  cester_assert_equal(60, thrown(guarded(0)));
+  cester_assert_equal(1, dare_sites_control("func guarded -"));
+  cester_assert_equal(0, thrown(guarded(0)));
+  cester_assert_equal(1, dare_sites_control("func guarded +"));
+  cester_assert_equal(60, thrown(guarded(0)));
+)
+
+CESTER_TEST(enable_dormant, ti,
+  cester_assert_equal(0, thrown(dormant(1000)));
+  cester_assert_equal(1, dare_sites_control("file sites_test.c level 3 +"));
+  cester_assert_equal(70, thrown(dormant(1000)));
+  cester_assert_equal(1, dare_sites_control("code 70 -"));
+  cester_assert_equal(0, thrown(dormant(1000)));
+)
+
+CESTER_TEST(disable_with_filter, ti,
+  struct dare_site_filter filter = { .match_code = 1, .code = 60 };
+  cester_assert_equal(1, dare_sites_set(&filter, 0));
+  cester_assert_equal(0, thrown(guarded(0)));
+  cester_assert_equal(1, dare_sites_set(&filter, 1));
+  cester_assert_equal(60, thrown(guarded(0)));
+)
+
+CESTER_TEST(malformed_query, ti,
+  cester_assert_equal(-1, dare_sites_control("func guarded"));
+  cester_assert_equal(-1, dare_sites_control("color red +"));
+  cester_assert_equal(0, dare_sites_control("file nowhere.c +; ; line 1-2 -"));
+)
+
+CESTER_TEST(watch_control_file, ti,
+  char const *path = "sites_test.ctl";
+  FILE *fp = fopen(path, "w");
+  fputs("func guarded -\n", fp);
+  fclose(fp);
+  cester_assert_equal(0, dare_sites_watch(path, SIGUSR1));
+  raise(SIGUSR1);
+  cester_assert_equal(0, thrown(guarded(0)));
+  remove(path);
+  dare_sites_control("func guarded +");
+)
+
+CESTER_TEST(disabled_array_not_scanned, ti,
+  double values[] = { 1, 2, 1.0 / 0.0 };
+  scans = 0;
+  cester_assert_equal(80, thrown(scan(values, 3)));
+  cester_assert_equal(1, scans);
+  cester_assert_equal(1, dare_sites_control("func scan -"));
+  cester_assert_equal(0, thrown(scan(values, 3)));
+  cester_assert_equal(1, scans);
+  cester_assert_equal(1, dare_sites_control("func scan +"));
+)
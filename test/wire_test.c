@@ -0,0 +1,153 @@
+#include "cester.h"
+#include "dare.h"
+
+CESTER_BODY(
+  static Exception load(int value) {
+    try (
+      throwf_lazy(30, "Cannot load %d", value);
+    ) catch (
+      dare_set_int(EVAR, "value", value);
+      dare_set_str(EVAR, "table", "users");
+      return EVAR;
+    )
+    return SUCCESS;
+  }
+
+  static Exception serve(int value) {
+    try (
+      check_cause(load(value), "Request failed", 31);
+    ) catch (
+      dare_set_double(EVAR, "ratio", 0.25);
+      set_transient(EVAR, 500);
+      return EVAR;
+    )
+    return SUCCESS;
+  }
+
+  static void cancel_chain(Exception e) {
+    while (e) {
+      Exception cause = get_cause(e);
+      cancel(e);
+      e = cause;
+    }
+  }
+)
+
+CESTER_TEST(wire_round_trip, ti,
+  Exception e = serve(7);
+  unsigned char buf[512];
+  size_t size = dare_serialize(e, buf, sizeof buf);
+  cester_assert_true(size > 0 && size < sizeof buf);
+
+  Exception copy = dare_deserialize(buf, size);
+  memset(buf, 0, sizeof buf);
+  cester_assert_not_null(copy);
+  cester_assert_str_equal("Request failed", get_msg(copy));
+  cester_assert_equal(31, get_code(copy));
+  cester_assert_true(is_transient(copy));
+  cester_assert_equal(500, get_retry_after(copy));
+  cester_assert_true(same_fingerprint(e, copy));
+  cester_assert_equal(2, get_depth(copy));
+
+  Exception cause = get_cause(copy);
+  cester_assert_str_equal("Cannot load 7", get_msg(cause));
+  cester_assert_ptr_equal(cause, get_root_cause(copy));
+  int64_t value;
+  char const *table;
+  double ratio;
+  cester_assert_equal(0, dare_get_int(cause, "value", &value));
+  cester_assert_equal(7, value);
+  cester_assert_equal(0, dare_get_str(cause, "table", &table));
+  cester_assert_str_equal("users", table);
+  cester_assert_equal(0, dare_get_double(copy, "ratio", &ratio));
+  cester_assert_true(ratio == 0.25);
+
+  cancel(copy);
+  cancel_chain(e);
+)
+
+CESTER_TEST(wire_size_needed, ti,
+  Exception e = serve(8);
+  unsigned char buf[16];
+  size_t size = dare_serialize(e, NULL, 0);
+  cester_assert_equal(size, dare_serialize(e, buf, sizeof buf));
+  cester_assert_true(size > sizeof buf);
+  cester_assert_equal(0, dare_serialize(NULL, buf, sizeof buf));
+  cancel_chain(e);
+)
+
+CESTER_TEST(wire_view, ti,
+  Exception e = serve(9);
+  unsigned char buf[512];
+  size_t size = dare_serialize(e, buf, sizeof buf);
+
+  struct dare_view v;
+  struct dare_record rec;
+  char const *key;
+  union dare_value value;
+  cester_assert_equal(0, dare_view_open(&v, buf, size));
+  cester_assert_equal(1, dare_view_next(&v, &rec));
+  cester_assert_equal(31, rec.code);
+  cester_assert_equal(DARE_FIELD_DOUBLE, dare_record_field(&rec, 0, &key, &value));
+  cester_assert_str_equal("ratio", key);
+  cester_assert_equal(1, rec.line_count);
+  cester_assert_str_equal("  at wire_test.c:18", dare_record_line(&rec, 0));
+  cester_assert_null((void *) dare_record_line(&rec, 1));
+
+  cester_assert_equal(1, dare_view_next(&v, &rec));
+  cester_assert_str_equal("Cannot load 9", rec.msg);
+  cester_assert_true((unsigned char const *) rec.msg > buf
+                     && (unsigned char const *) rec.msg < buf + size);
+  cester_assert_equal(DARE_FIELD_STR, dare_record_field(&rec, 1, &key, &value));
+  cester_assert_str_equal("users", value.p);
+  cester_assert_equal(-1, dare_record_field(&rec, 2, &key, &value));
+  cester_assert_equal(0, dare_view_next(&v, &rec));
+  cancel_chain(e);
+)
+
+CESTER_TEST(wire_errno_detail, ti,
+  Exception e = NULL;
+  try (
+    check_rc(-EPIPE);
+  ) catch (
+    e = EVAR;
+  )
+  int x = 3;
+  try (
+    assert_equal(x, 4, "Wrong x", 32);
+  ) catch (
+    e = new_exception("Both", 33, e);
+    cancel(EVAR);
+  )
+  unsigned char buf[512];
+  Exception copy = dare_deserialize(buf, dare_serialize(e, buf, sizeof buf));
+  cester_assert_equal(EPIPE, get_errno(get_cause(copy)));
+  cester_assert_str_equal(get_msg(get_cause(e)), get_msg(get_cause(copy)));
+  cester_assert_null((void *) get_detail(copy));
+  cancel(copy);
+  cancel_chain(e);
+
+  try (
+    assert_equal(x, 4, "Wrong x", 32);
+  ) catch (
+    copy = dare_deserialize(buf, dare_serialize(EVAR, buf, sizeof buf));
+    cancel(EVAR);
+  )
+  cester_assert_str_equal("expected x == 4, got 3 vs 4", get_detail(copy));
+  cancel(copy);
+)
+
+CESTER_TEST(wire_malformed, ti,
+  Exception e = serve(10);
+  unsigned char buf[512];
+  size_t size = dare_serialize(e, buf, sizeof buf);
+  struct dare_view v;
+  for (size_t n = 0; n < size; n++) {
+    cester_assert_null(dare_deserialize(buf, n));
+    cester_assert_equal(-1, dare_view_open(&v, buf, n));
+  }
+  buf[2] = 99;
+  cester_assert_null(dare_deserialize(buf, size));
+  cester_assert_null(dare_deserialize(NULL, size));
+  cancel_chain(e);
+)